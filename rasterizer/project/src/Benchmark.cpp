@@ -0,0 +1,317 @@
+#include "pch.h"
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "Utils.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+
+namespace dae
+{
+	Benchmark::Benchmark(const BenchmarkSettings& settings) :
+		m_Settings{ settings }
+	{
+		m_FrameTimesMs.reserve(m_Settings.frameCount);
+		m_FrameStats.reserve(m_Settings.frameCount);
+	}
+
+	bool Benchmark::ParseArguments(int argc, char* args[], BenchmarkSettings& settings)
+	{
+		bool isBenchmark = false;
+		for (int idx{ 1 }; idx < argc; ++idx)
+		{
+			const std::string argument = args[idx];
+			const bool hasValue = idx + 1 < argc;
+
+			if (argument == "--benchmark")
+				isBenchmark = true;
+			else if (argument == "--mesh" && hasValue)
+				settings.meshName = args[++idx];
+			else if (argument == "--frames" && hasValue)
+				settings.frameCount = std::max(1, std::atoi(args[++idx]));
+			else if (argument == "--warmup" && hasValue)
+				settings.warmupFrames = std::max(0, std::atoi(args[++idx]));
+			else if (argument == "--width" && hasValue)
+				settings.width = std::max(1, std::atoi(args[++idx]));
+			else if (argument == "--height" && hasValue)
+				settings.height = std::max(1, std::atoi(args[++idx]));
+			else if (argument == "--threads" && hasValue)
+				settings.threadCount = static_cast<uint32_t>(std::max(0, std::atoi(args[++idx])));
+			else if (argument == "--deferred")
+				settings.isDeferredShading = true;
+			else if (argument == "--cull" && hasValue)
+			{
+				const std::string cullMode = args[++idx];
+				if (cullMode == "back") settings.cullMode = CullMode::Back;
+				else if (cullMode == "front") settings.cullMode = CullMode::Front;
+				else settings.cullMode = CullMode::None;
+			}
+			else if (argument == "--filter" && hasValue)
+			{
+				const std::string filteringMethod = args[++idx];
+				if (filteringMethod == "linear") settings.filteringMethod = FilteringMethod::Linear;
+				else if (filteringMethod == "anisotropic") settings.filteringMethod = FilteringMethod::Anisotropic;
+				else settings.filteringMethod = FilteringMethod::Point;
+			}
+			else if (argument == "--texture-layout" && hasValue)
+				settings.texelLayout = std::string{ args[++idx] } == "linear" ? TexelLayout::Linear : TexelLayout::Tiled;
+			else if (argument == "--shading" && hasValue)
+			{
+				const std::string shadingMode = args[++idx];
+				if (shadingMode == "observed") settings.shadingMode = ShadingMode::ObservedArea;
+				else if (shadingMode == "diffuse") settings.shadingMode = ShadingMode::Diffuse;
+				else if (shadingMode == "specular") settings.shadingMode = ShadingMode::Specular;
+				else settings.shadingMode = ShadingMode::Combined;
+			}
+			else if (argument == "--normal-map" && hasValue)
+				settings.isNormalMapVisible = std::string{ args[++idx] } != "off";
+			else if (argument == "--depth")
+				settings.isDepthVisualization = true;
+			else if (argument == "--fire" && hasValue)
+				settings.isFireMeshVisible = std::string{ args[++idx] } != "off";
+			else if (argument == "--transparency" && hasValue)
+			{
+				const std::string transparencyMode = args[++idx];
+				if (transparencyMode == "unsorted") settings.transparencyMode = TransparencyMode::SubmissionOrder;
+				else if (transparencyMode == "oit") settings.transparencyMode = TransparencyMode::WeightedBlended;
+				else settings.transparencyMode = TransparencyMode::Sorted;
+			}
+			else if (argument == "--msaa" && hasValue)
+				settings.sampleCount = std::clamp(std::atoi(args[++idx]), 1, MAX_SAMPLE_COUNT);
+			else if (argument == "--csv" && hasValue)
+				settings.csvPath = args[++idx];
+			else if (argument == "--image" && hasValue)
+				settings.imagePath = args[++idx];
+			else if (argument == "--profile" && hasValue)
+				settings.profilePath = args[++idx];
+			else if (argument == "--trace" && hasValue)
+				settings.tracePath = args[++idx];
+			else if (argument == "--trace-frames" && hasValue)
+				settings.traceFrameCount = std::max(1, std::atoi(args[++idx]));
+			else if (argument == "--verify-import")
+			{
+				isBenchmark = true;
+				settings.isImportVerification = true;
+			}
+			else
+				std::cout << "Unknown argument: " << argument << '\n';
+		}
+		return isBenchmark;
+	}
+
+	int Benchmark::Run()
+	{
+		if (m_Settings.isImportVerification)
+			return VerifyImport();
+
+		const std::string meshFile = "resources/" + m_Settings.meshName + ".obj";
+		if (!std::ifstream(meshFile))
+		{
+			std::cout << "Benchmark: could not open " << meshFile << '\n';
+			return 1;
+		}
+
+		const auto startupStart = std::chrono::high_resolution_clock::now();
+		Renderer renderer{ m_Settings.width, m_Settings.height, m_Settings.meshName, m_Settings.threadCount, m_Settings.sampleCount };
+		m_StartupMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startupStart).count();
+		if (m_Settings.isDeferredShading)
+			renderer.ToggleDeferredShading();
+		renderer.SetSoftwareCullMode(m_Settings.cullMode);
+		renderer.SetFilteringMethod(m_Settings.filteringMethod);
+		renderer.SetTexelLayout(m_Settings.texelLayout);
+		renderer.SetShadingMode(m_Settings.shadingMode);
+		renderer.SetNormalMapVisible(m_Settings.isNormalMapVisible);
+		renderer.SetDepthVisualization(m_Settings.isDepthVisualization);
+		renderer.SetFireMeshVisible(m_Settings.isFireMeshVisible);
+		renderer.SetTransparencyMode(m_Settings.transparencyMode);
+		renderer.GetProfiler().SetFrameCapacity(m_Settings.frameCount);	// keeps every measured frame
+
+		// Warm up (caches, allocations) on the first camera position
+		for (int frame{}; frame < m_Settings.warmupFrames; ++frame)
+		{
+			UpdateCamera(renderer.GetCamera(), 0);
+			renderer.Render();
+		}
+		renderer.GetProfiler().Clear();
+		if (!m_Settings.tracePath.empty())
+			renderer.GetProfiler().StartTrace(m_Settings.tracePath, m_Settings.traceFrameCount);
+
+		for (int frame{}; frame < m_Settings.frameCount; ++frame)
+		{
+			UpdateCamera(renderer.GetCamera(), frame);
+
+			const auto start = std::chrono::high_resolution_clock::now();
+			renderer.Render();
+			const auto end = std::chrono::high_resolution_clock::now();
+
+			m_FrameTimesMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+			m_FrameStats.push_back(renderer.GetFrameStats());
+		}
+
+		if (!renderer.GetProfiler().StopTrace())	// fewer frames than traceFrameCount
+			std::cout << "Benchmark: could not write " << m_Settings.tracePath << '\n';
+
+		PrintReport(renderer.GetThreadCount(), renderer.GetSampleCount(), renderer.GetProfiler());
+
+		if (!m_Settings.csvPath.empty() && !WriteCSV())
+			std::cout << "Benchmark: could not write " << m_Settings.csvPath << '\n';
+
+		if (!m_Settings.imagePath.empty() && SDL_SaveBMP(renderer.GetBackBuffer(), m_Settings.imagePath.c_str()) != 0)
+			std::cout << "Benchmark: could not write " << m_Settings.imagePath << '\n';
+
+		if (!m_Settings.profilePath.empty() && !renderer.GetProfiler().Write(m_Settings.profilePath))
+			std::cout << "Benchmark: could not write " << m_Settings.profilePath << '\n';
+
+		return 0;
+	}
+
+	// Parses every mesh serially and in forced small chunks, both handednesses, and compares the results bit for bit
+	int Benchmark::VerifyImport() const
+	{
+		std::vector<std::string> meshFiles{};
+		std::error_code error{};
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator("resources", error))
+		{
+			if (entry.path().extension() == ".obj")
+				meshFiles.push_back(entry.path().generic_string());
+		}
+		std::sort(meshFiles.begin(), meshFiles.end());
+		if (meshFiles.empty())
+		{
+			std::cout << "Benchmark: no .obj files in resources\n";
+			return 1;
+		}
+
+		JobSystem jobSystem{ m_Settings.threadCount };
+		int mismatchCount{};
+		for (const std::string& meshFile : meshFiles)
+		{
+			for (const bool flipAxisAndWinding : { true, false })
+			{
+				std::vector<Vertex_In> serialVertices{}, parallelVertices{};
+				std::vector<uint32_t> serialIndices{}, parallelIndices{};
+				const bool isParsed = Utils::ParseOBJ(meshFile, serialVertices, serialIndices, flipAxisAndWinding)
+					&& ParallelObjParser::Parse(meshFile, parallelVertices, parallelIndices, flipAxisAndWinding, jobSystem, VERIFY_CHUNK_SIZE);
+
+				// First differing vertex / index, size() when the common part matches
+				size_t vertexIdx{};
+				const size_t vertexCount = std::min(serialVertices.size(), parallelVertices.size());
+				while (vertexIdx < vertexCount && std::memcmp(&serialVertices[vertexIdx], &parallelVertices[vertexIdx], sizeof(Vertex_In)) == 0)
+					++vertexIdx;
+				const size_t indexIdx = std::mismatch(serialIndices.begin(), serialIndices.end(), parallelIndices.begin(), parallelIndices.end()).first - serialIndices.begin();
+
+				const bool isIdentical = isParsed && serialVertices.size() == parallelVertices.size() && vertexIdx == vertexCount
+					&& serialIndices.size() == parallelIndices.size() && indexIdx == serialIndices.size();
+				std::cout << (isIdentical ? "   identical " : "   MISMATCH  ") << meshFile << (flipAxisAndWinding ? " (flipped)" : "")
+					<< ": " << serialVertices.size() << '/' << parallelVertices.size() << " vertices, " << serialIndices.size() << '/' << parallelIndices.size() << " indices";
+				if (!isParsed)
+					std::cout << ", could not parse";
+				else if (!isIdentical)
+					std::cout << ", first differing vertex " << vertexIdx << ", index " << indexIdx;
+				std::cout << '\n';
+
+				mismatchCount += !isIdentical;
+			}
+		}
+
+		std::cout << "Benchmark: ParallelObjParser (" << VERIFY_CHUNK_SIZE << " byte chunks, " << jobSystem.GetThreadCount() << " threads) "
+			<< (mismatchCount == 0 ? "matches" : "differs from") << " Utils::ParseOBJ\n";
+		return mismatchCount == 0 ? 0 : 1;
+	}
+
+	// Scripted path: one orbit around the mesh, dollying in to a close-up halfway (only depends on the frame index)
+	void Benchmark::UpdateCamera(Camera& camera, int frame) const
+	{
+		const Vector3 target{ 0.f, 4.f, 50.f };
+
+		const float t = static_cast<float>(frame) / m_Settings.frameCount;
+		const float angle = PI_2 * t;
+		const float radius = Lerpf(35.f, 12.f, .5f - .5f * cosf(PI_2 * t));
+		const float height = 6.f + 4.f * sinf(2.f * PI_2 * t);
+
+		camera.origin = target + Vector3{ sinf(angle) * radius, height, -cosf(angle) * radius };
+		camera.LookAt(target);
+	}
+
+	void Benchmark::PrintReport(uint32_t threadCount, int sampleCount, const Profiler& profiler) const
+	{
+		std::vector<double> sortedTimes = m_FrameTimesMs;
+		std::sort(sortedTimes.begin(), sortedTimes.end());
+
+		// nearest-rank percentile
+		auto percentile = [&sortedTimes](double p)
+			{
+				const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sortedTimes.size()));
+				return sortedTimes[std::clamp<size_t>(rank, 1, sortedTimes.size()) - 1];
+			};
+
+		double totalMs{};
+		uint64_t totalTriangles{};
+		uint64_t totalPixels{};
+		uint64_t totalShadedPixels{};
+		uint64_t totalBlendedPixels{};
+		uint64_t totalBackface{}, totalZeroArea{}, totalOffscreen{}, totalClipped{};
+		for (size_t idx{}; idx < m_FrameTimesMs.size(); ++idx)
+		{
+			totalBackface += m_FrameStats[idx].backfaceCulledCount;
+			totalZeroArea += m_FrameStats[idx].zeroAreaCulledCount;
+			totalOffscreen += m_FrameStats[idx].offscreenCulledCount;
+			totalClipped += m_FrameStats[idx].clippedCount;
+			totalMs += m_FrameTimesMs[idx];
+			totalTriangles += m_FrameStats[idx].triangleCount;
+			totalPixels += m_FrameStats[idx].pixelCount;
+			totalShadedPixels += m_FrameStats[idx].shadedPixelCount;
+			totalBlendedPixels += m_FrameStats[idx].blendedPixelCount;
+		}
+		const double totalSeconds = totalMs / 1000.0;
+
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << STRINGCOLOR_SOFTWARE_GREEN << "[Benchmark - SOFTWARE] " << m_Settings.meshName << ' '
+			<< m_Settings.width << 'x' << m_Settings.height << ", " << m_FrameTimesMs.size() << " frames, " << threadCount << " threads"
+			<< (m_Settings.isDeferredShading ? ", deferred" : "");
+		if (sampleCount > 1)
+			std::cout << ", " << sampleCount << "x MSAA";
+		std::cout << '\n' << STRINGCOLOR_RESET;
+		std::cout << "   startup ms " << m_StartupMs << " (mesh import + textures)\n";
+		std::cout << "   frame ms   avg " << totalMs / m_FrameTimesMs.size()
+			<< "   min " << sortedTimes.front() << "   max " << sortedTimes.back() << '\n';
+		std::cout << "   percentile p50 " << percentile(50) << "   p90 " << percentile(90)
+			<< "   p95 " << percentile(95) << "   p99 " << percentile(99) << '\n';
+		std::cout << std::setprecision(0);
+		std::cout << "   triangles/s " << totalTriangles / totalSeconds << "   pixels/s " << totalPixels / totalSeconds
+			<< "   shaded pixels/s " << totalShadedPixels / totalSeconds << "   blended pixels/s " << totalBlendedPixels / totalSeconds << '\n';
+		const double frameCount = static_cast<double>(m_FrameTimesMs.size());
+		std::cout << "   triangles/frame culled: backface " << totalBackface / frameCount << "   zero area " << totalZeroArea / frameCount
+			<< "   offscreen " << totalOffscreen / frameCount << "   clipped " << totalClipped / frameCount << '\n';
+
+		// Where a frame goes (tile stages are thread time, summed over the tiles)
+		const ProfileFrame average = profiler.GetAverage();
+		std::cout << std::setprecision(3) << "   stage ms  ";
+		for (const ProfileStage stage : { ProfileStage::VertexTransform, ProfileStage::TriangleSetup, ProfileStage::Rasterization, ProfileStage::Shading })
+			std::cout << "   " << Profiler::GetName(stage) << ' ' << average.stageMs[static_cast<size_t>(stage)];
+		std::cout << '\n' << std::setprecision(0) << "   per frame ";
+		for (size_t counterIdx{}; counterIdx < PROFILE_COUNTER_COUNT; ++counterIdx)
+			std::cout << "   " << Profiler::GetName(static_cast<ProfileCounter>(counterIdx)) << ' ' << average.counters[counterIdx];
+		std::cout << '\n';
+		std::cout << std::defaultfloat;
+	}
+
+	bool Benchmark::WriteCSV() const
+	{
+		std::ofstream file(m_Settings.csvPath);
+		if (!file)
+			return false;
+
+		file << "frame,ms,triangles,backface,zeroArea,offscreen,clipped,pixels,shaded,blended\n";
+		for (size_t idx{}; idx < m_FrameTimesMs.size(); ++idx)
+		{
+			const FrameStats& stats = m_FrameStats[idx];
+			file << idx << ',' << m_FrameTimesMs[idx] << ',' << stats.triangleCount << ',' << stats.backfaceCulledCount << ',' << stats.zeroAreaCulledCount
+				<< ',' << stats.offscreenCulledCount << ',' << stats.clippedCount << ',' << stats.pixelCount << ',' << stats.shadedPixelCount << ',' << stats.blendedPixelCount << '\n';
+		}
+
+		return true;
+	}
+}
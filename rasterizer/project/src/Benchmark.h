@@ -0,0 +1,74 @@
+#pragma once
+
+//includes
+#include "pch.h"
+#include "Renderer.h"
+
+namespace dae
+{
+	struct BenchmarkSettings
+	{
+		std::string meshName{ "Kart" };		// resources/<meshName>.obj (Kart or vehicle)
+		int frameCount{ 300 };
+		int warmupFrames{ 10 };
+		int width{ 640 };
+		int height{ 480 };
+		uint32_t threadCount{ 0 };		// 0 = all cores
+		bool isDeferredShading{ false };	// visibility buffer + one shading pass
+		CullMode cullMode{ CullMode::None };
+		FilteringMethod filteringMethod{ FilteringMethod::Point };
+		TexelLayout texelLayout{ TexelLayout::Tiled };
+		ShadingMode shadingMode{ ShadingMode::Combined };
+		bool isNormalMapVisible{ true };
+		bool isDepthVisualization{ false };
+		bool isFireMeshVisible{ true };		// partial coverage pass
+		TransparencyMode transparencyMode{ TransparencyMode::Sorted };
+		int sampleCount{ 1 };		// MSAA: 1, 2, 4 or 8 (also used by the windowed renderer)
+
+		std::string csvPath{};		// optional: per-frame results
+		std::string imagePath{};	// optional: last frame as .bmp
+		std::string profilePath{};	// optional: stage times + counters per frame (.csv or .json), also written by the windowed renderer on exit
+		std::string tracePath{};	// optional: trace event JSON (Perfetto / chrome://tracing) of the first traceFrameCount measured frames, also in the window
+		int traceFrameCount{ 10 };
+
+		bool isImportVerification{ false };		// --verify-import: only checks ParallelObjParser against Utils::ParseOBJ on every resources/*.obj
+	};
+
+	// Headless benchmark of the software rasterizer:
+	// renders N frames along a scripted camera path and reports frame times + throughput
+	class Benchmark final
+	{
+	public:
+		// Constructor + Destructor
+		// ------
+		explicit Benchmark(const BenchmarkSettings& settings);
+		~Benchmark() = default;
+
+		// Rule of 5
+		// ------
+		Benchmark(const Benchmark&) = delete;
+		Benchmark(Benchmark&&) noexcept = delete;
+		Benchmark& operator=(const Benchmark&) = delete;
+		Benchmark& operator=(Benchmark&&) noexcept = delete;
+
+
+		// Member Functions
+		// ------
+		static bool ParseArguments(int argc, char* args[], BenchmarkSettings& settings);	// --benchmark [--mesh name] [--frames n] ...
+		int Run();
+
+	private:
+		static constexpr size_t VERIFY_CHUNK_SIZE{ 256 };	// bytes, splits faces from the vertices they use as often as possible
+
+		int VerifyImport() const;
+		void UpdateCamera(Camera& camera, int frame) const;
+		void PrintReport(uint32_t threadCount, int sampleCount, const Profiler& profiler) const;
+		bool WriteCSV() const;
+
+		BenchmarkSettings m_Settings;
+
+		double m_StartupMs{};
+		std::vector<double> m_FrameTimesMs;
+		std::vector<FrameStats> m_FrameStats;
+	};
+}
@@ -46,6 +46,13 @@ namespace dae{
 			aspectRatio = _aspectRatio;
 		}
 
+		void LookAt(const Vector3& target)	// used by scripted camera paths (benchmark)
+		{
+			forward = (target - origin).Normalized();
+			right = Vector3::Cross(Vector3::UnitY, forward).Normalized();
+			up = Vector3::Cross(forward, right).Normalized();
+		}
+
 		Matrix GetViewMatrix() const
 		{
 			Matrix invViewMatrix{};
@@ -72,7 +79,6 @@ namespace dae{
 			const float deltaTime = pTimer->GetElapsed();
  
 			float moveSpeed{ 30.f };
-			const float rotationSpeed{ 30.f };
 
 			//Keyboard Input
 			const uint8_t* pKeyboardState = SDL_GetKeyboardState(nullptr);
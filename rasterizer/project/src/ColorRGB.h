@@ -18,7 +18,7 @@ namespace dae
 				*this /= maxValue;
 		}
 
-		static ColorRGB Lerp(const ColorRGB& c1, const ColorRGB& c2, float factor)
+		inline ColorRGB Lerp(const ColorRGB& c1, const ColorRGB& c2, float factor)
 		{
 			return { Lerpf(c1.r, c2.r, factor), Lerpf(c1.g, c2.g, factor), Lerpf(c1.b, c2.b, factor) };
 		}
@@ -113,14 +113,14 @@ namespace dae
 
 	namespace colors
 	{
-		static ColorRGB Red{ 1,0,0 };
-		static ColorRGB Blue{ 0,0,1 };
-		static ColorRGB Green{ 0,1,0 };
-		static ColorRGB Yellow{ 1,1,0 };
-		static ColorRGB Cyan{ 0,1,1 };
-		static ColorRGB Magenta{ 1,0,1 };
-		static ColorRGB White{ 1,1,1 };
-		static ColorRGB Black{ 0,0,0 };
-		static ColorRGB Gray{ 0.5f,0.5f,0.5f };
+		inline ColorRGB Red{ 1,0,0 };
+		inline ColorRGB Blue{ 0,0,1 };
+		inline ColorRGB Green{ 0,1,0 };
+		inline ColorRGB Yellow{ 1,1,0 };
+		inline ColorRGB Cyan{ 0,1,1 };
+		inline ColorRGB Magenta{ 1,0,1 };
+		inline ColorRGB White{ 1,1,1 };
+		inline ColorRGB Black{ 0,0,0 };
+		inline ColorRGB Gray{ 0.5f,0.5f,0.5f };
 	}
 }
\ No newline at end of file
@@ -5,13 +5,6 @@
 
 namespace dae
 {
-	enum class FilteringMethod
-	{
-		Point = 0,
-		Linear = 1,
-		Anisotropic = 2
-	};
-
 	class Effect
 	{
 	public:
@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "JobSystem.h"
+
+namespace dae
+{
+	JobSystem::JobSystem(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		for (uint32_t idx{}; idx < threadCount; ++idx)
+			m_Queues.push_back(std::make_unique<WorkQueue>());
+
+		// Thread 0 is the one calling ParallelFor
+		for (uint32_t idx{ 1 }; idx < threadCount; ++idx)
+			m_Workers.emplace_back(&JobSystem::WorkerLoop, this, idx);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard lock{ m_WakeMutex };
+			m_IsRunning = false;
+		}
+		m_WakeCondition.notify_all();
+
+		for (auto& worker : m_Workers)
+			worker.join();
+	}
+
+
+	void JobSystem::ParallelFor(uint32_t jobCount, const std::function<void(uint32_t jobIdx)>& job)
+	{
+		if (jobCount == 0)
+			return;
+
+		// Single thread -> no queues needed
+		if (m_Workers.empty())
+		{
+			for (uint32_t jobIdx{}; jobIdx < jobCount; ++jobIdx)
+				job(jobIdx);
+			return;
+		}
+
+		m_pJob = &job;
+		m_PendingJobs.store(jobCount);
+
+		// Deal the jobs out round robin, neighbouring jobs end up on different threads
+		const uint32_t threadCount = GetThreadCount();
+		for (uint32_t threadIdx{}; threadIdx < threadCount; ++threadIdx)
+		{
+			std::lock_guard lock{ m_Queues[threadIdx]->mutex };
+			for (uint32_t jobIdx{ threadIdx }; jobIdx < jobCount; jobIdx += threadCount)
+				m_Queues[threadIdx]->jobs.push_back(jobIdx);
+		}
+
+		{
+			std::lock_guard lock{ m_WakeMutex };
+			++m_Generation;
+		}
+		m_WakeCondition.notify_all();
+
+		// Help out until every job has finished (not only been taken)
+		while (m_PendingJobs.load() > 0)
+		{
+			if (!RunNextJob(0))
+				std::this_thread::yield();
+		}
+
+		m_pJob = nullptr;
+	}
+
+	void JobSystem::WorkerLoop(uint32_t threadIdx)
+	{
+		uint64_t generation{};
+		while (true)
+		{
+			{
+				std::unique_lock lock{ m_WakeMutex };
+				m_WakeCondition.wait(lock, [&]() { return !m_IsRunning || m_Generation != generation; });
+
+				if (!m_IsRunning)
+					return;
+				generation = m_Generation;
+			}
+
+			while (RunNextJob(threadIdx)) {}
+		}
+	}
+
+	bool JobSystem::RunNextJob(uint32_t threadIdx)
+	{
+		uint32_t jobIdx{};
+		bool hasJob = false;
+
+		// Own queue (back)
+		{
+			WorkQueue& queue = *m_Queues[threadIdx];
+			std::lock_guard lock{ queue.mutex };
+			if (!queue.jobs.empty())
+			{
+				jobIdx = queue.jobs.back();
+				queue.jobs.pop_back();
+				hasJob = true;
+			}
+		}
+
+		// Steal (front)
+		const uint32_t threadCount = GetThreadCount();
+		for (uint32_t offset{ 1 }; !hasJob && offset < threadCount; ++offset)
+		{
+			WorkQueue& victim = *m_Queues[(threadIdx + offset) % threadCount];
+			std::lock_guard lock{ victim.mutex };
+			if (!victim.jobs.empty())
+			{
+				jobIdx = victim.jobs.front();
+				victim.jobs.pop_front();
+				hasJob = true;
+			}
+		}
+
+		if (!hasJob)
+			return false;
+
+		(*m_pJob)(jobIdx);
+		m_PendingJobs.fetch_sub(1);
+		return true;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+//includes
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	// Work-stealing thread pool:
+	// every thread owns a queue, pops its own jobs from the back and steals from the front of the others when it runs dry
+	class JobSystem final
+	{
+	public:
+		// Constructor + Destructor
+		// ------
+		explicit JobSystem(uint32_t threadCount = 0);	// 0 = one thread per hardware core (the calling thread counts as one)
+		~JobSystem();
+
+		// Rule of 5
+		// ------
+		JobSystem(const JobSystem&) = delete;
+		JobSystem(JobSystem&&) noexcept = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+		JobSystem& operator=(JobSystem&&) noexcept = delete;
+
+
+		// Member Functions
+		// ------
+		void ParallelFor(uint32_t jobCount, const std::function<void(uint32_t jobIdx)>& job);	// blocks until every job ran, the caller helps out
+
+		// Getter func
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Queues.size()); };
+
+	private:
+		struct WorkQueue
+		{
+			std::mutex mutex;
+			std::deque<uint32_t> jobs;
+		};
+
+		void WorkerLoop(uint32_t threadIdx);
+		bool RunNextJob(uint32_t threadIdx);	// own queue first, then steal -> false when there is nothing left
+
+		std::vector<std::thread> m_Workers;
+		std::vector<std::unique_ptr<WorkQueue>> m_Queues;	// [0] = calling thread
+
+		const std::function<void(uint32_t)>* m_pJob{ nullptr };
+		std::atomic<uint32_t> m_PendingJobs{};
+
+		std::mutex m_WakeMutex;
+		std::condition_variable m_WakeCondition;
+		uint64_t m_Generation{};
+		bool m_IsRunning{ true };
+	};
+}
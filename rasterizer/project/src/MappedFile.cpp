@@ -0,0 +1,97 @@
+//includes
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dae
+{
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+#if defined(_WIN32)
+		m_FileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (m_FileHandle == INVALID_HANDLE_VALUE)
+		{
+			m_FileHandle = nullptr;
+			return false;
+		}
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(m_FileHandle, &fileSize) || fileSize.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+
+		m_MappingHandle = CreateFileMappingA(m_FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_MappingHandle)
+		{
+			Close();
+			return false;
+		}
+
+		m_pData = static_cast<const char*>(MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+		m_Size = static_cast<size_t>(fileSize.QuadPart);
+#else
+		const int fileDescriptor = open(path.c_str(), O_RDONLY);
+		if (fileDescriptor < 0)
+			return false;
+
+		struct stat fileStatus{};
+		if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+		{
+			close(fileDescriptor);
+			return false;
+		}
+
+		void* pMapping = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		close(fileDescriptor);	// the mapping keeps the file alive
+		if (pMapping == MAP_FAILED)
+			return false;
+
+		m_pData = static_cast<const char*>(pMapping);
+		m_Size = static_cast<size_t>(fileStatus.st_size);
+#endif
+
+		if (!m_pData)
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+#if defined(_WIN32)
+		if (m_pData)
+			UnmapViewOfFile(m_pData);
+		if (m_MappingHandle)
+			CloseHandle(m_MappingHandle);
+		if (m_FileHandle)
+			CloseHandle(m_FileHandle);
+		m_MappingHandle = nullptr;
+		m_FileHandle = nullptr;
+#else
+		if (m_pData)
+			munmap(const_cast<char*>(m_pData), m_Size);
+#endif
+		m_pData = nullptr;
+		m_Size = 0;
+	}
+}
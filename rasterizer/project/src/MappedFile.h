@@ -0,0 +1,44 @@
+#pragma once
+
+//includes
+#include <cstddef>
+#include <string>
+
+namespace dae
+{
+	// Read-only memory mapping of a whole file (the OS pages it in on demand, no copy into a buffer)
+	class MappedFile final
+	{
+	public:
+		// Constructor + Destructor
+		// ------
+		MappedFile() = default;
+		~MappedFile();
+
+		// Rule of 5
+		// ------
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&&) noexcept = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile& operator=(MappedFile&&) noexcept = delete;
+
+
+		// Member Functions
+		// ------
+		bool Open(const std::string& path);
+		void Close();
+
+		// Getter func
+		const char* GetData() const { return m_pData; };
+		size_t GetSize() const { return m_Size; };
+
+	private:
+		const char* m_pData = nullptr;
+		size_t m_Size{};
+
+#if defined(_WIN32)
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
+#endif
+	};
+}
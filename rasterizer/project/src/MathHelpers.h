@@ -62,8 +62,6 @@ namespace dae
 	inline float Remap(const float v, const float min, const float max)	// remap the value from [min,max] to [0,1]
 	{
 		if (v < min) return 0;	 // Clamp below range
-		// This should be done in renderer by checking the min value of all depth buffer values and using that as the input for min. 
-		// BUT -> because these multiple for loops etc tank performance, I will keep it like this for now.
 		if (v > max) return 1;	 // Clamp above range
 		if (max - min == 0) return 0; // Avoid division by zero
 
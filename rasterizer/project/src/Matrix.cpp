@@ -62,7 +62,7 @@ namespace dae {
 		return TransformPoint(p.x, p.y, p.z, p.w);
 	}
 
-	Vector4 Matrix::TransformPoint(float x, float y, float z, float w) const
+	Vector4 Matrix::TransformPoint(float x, float y, float z, float /*w*/) const
 	{
 		return Vector4{
 			data[0].x * x + data[1].x * y + data[2].x * z + data[3].x,
@@ -211,8 +211,8 @@ namespace dae {
 	{
 		return {
 			{1, 0, 0, 0},
-			{0, cos(pitch), -sin(pitch), 0},
-			{0, sin(pitch), cos(pitch), 0},
+			{0, std::cos(pitch), -std::sin(pitch), 0},
+			{0, std::sin(pitch), std::cos(pitch), 0},
 			{0, 0, 0, 1}
 		};
 	}
@@ -220,9 +220,9 @@ namespace dae {
 	Matrix Matrix::CreateRotationY(float yaw)
 	{
 		return {
-			{cos(yaw), 0, -sin(yaw), 0},
+			{std::cos(yaw), 0, -std::sin(yaw), 0},
 			{0, 1, 0, 0},
-			{sin(yaw), 0, cos(yaw), 0},
+			{std::sin(yaw), 0, std::cos(yaw), 0},
 			{0, 0, 0, 1}
 		};
 	}
@@ -230,8 +230,8 @@ namespace dae {
 	Matrix Matrix::CreateRotationZ(float roll)
 	{
 		return {
-			{cos(roll), sin(roll), 0, 0},
-			{-sin(roll), cos(roll), 0, 0},
+			{std::cos(roll), std::sin(roll), 0, 0},
+			{-std::sin(roll), std::cos(roll), 0, 0},
 			{0, 0, 1, 0},
 			{0, 0, 0, 1}
 		};
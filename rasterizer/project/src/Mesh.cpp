@@ -2,20 +2,13 @@
 
 namespace dae {
 
-	Mesh::Mesh(ID3D11Device* pDevice, const std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices, bool isPartialCoverage)
+	Mesh::Mesh(bool isPartialCoverage, const std::string& texturePath)
 		:m_IsPartialCoverage{ isPartialCoverage }
 	{
-		// Create an instance of the effect class you just created
-		if(isPartialCoverage)
-			m_pEffect = new EffectPartialCoverage(pDevice, L"../../../../../resources/PosCol3D_PartialCoverage.fx");
-		else 
-			m_pEffect = new EffectDefault(pDevice, L"../../../../../resources/PosCol3D.fx");
-
-		m_pTechnique = m_pEffect->GetTechnique(m_FilteringMethod);
-
+		// Load textures ( <texturePath>_diffuse.png, ... )
 		if (isPartialCoverage)
 		{
-			m_pDiffuseTexture = Texture::LoadFromFile("resources/fireFX_diffuse.png", pDevice);
+			m_pDiffuseTexture = Texture::LoadFromFile(texturePath + "_diffuse.png");
 
 			m_pNormalTexture =		nullptr;
 			m_pSpecularTexture =	nullptr;
@@ -23,12 +16,29 @@ namespace dae {
 		}
 		else
 		{
-			m_pDiffuseTexture = Texture::LoadFromFile("resources/Kart_diffuse.png", pDevice);
-			m_pNormalTexture = Texture::LoadFromFile("resources/Kart_normal.png", pDevice);
-			m_pSpecularTexture = Texture::LoadFromFile("resources/Kart_specular.png", pDevice);
-			m_pGlossinessTexture = Texture::LoadFromFile("resources/Kart_gloss.png", pDevice);
+			m_pDiffuseTexture = Texture::LoadFromFile(texturePath + "_diffuse.png");
+			m_pNormalTexture = Texture::LoadFromFile(texturePath + "_normal.png");
+			m_pSpecularTexture = Texture::LoadFromFile(texturePath + "_specular.png", TexelFormat::R32F);		// greyscale, sampled as floats
+			m_pGlossinessTexture = Texture::LoadFromFile(texturePath + "_gloss.png", TexelFormat::R32F);
+
+			m_pMaterialTexture = Texture::CreateMaterial(m_pDiffuseTexture, m_pNormalTexture, m_pSpecularTexture, m_pGlossinessTexture);
 		}
-			
+	}
+
+#if ENABLE_DIRECTX
+	void Mesh::InitializeHardware(ID3D11Device* pDevice, const std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices)
+	{
+		for (Texture* pTexture : { m_pDiffuseTexture, m_pNormalTexture, m_pSpecularTexture, m_pGlossinessTexture })
+			if (pTexture)
+				pTexture->CreateShaderResource(pDevice);
+
+		// Create an instance of the effect class you just created
+		if(m_IsPartialCoverage)
+			m_pEffect = new EffectPartialCoverage(pDevice, L"../../../../../resources/PosCol3D_PartialCoverage.fx");
+		else 
+			m_pEffect = new EffectDefault(pDevice, L"../../../../../resources/PosCol3D.fx");
+
+		m_pTechnique = m_pEffect->GetTechnique(m_FilteringMethod);
 
 
 		// Create the vertex layout
@@ -98,11 +108,13 @@ namespace dae {
 			return;
 
 	}
+#endif
 
 	Mesh::~Mesh()
 	{
 		// Release resources - oposite order of constr
 
+#if ENABLE_DIRECTX
 		if (m_pIndexBuffer)
 			m_pIndexBuffer->Release();
 
@@ -114,17 +126,22 @@ namespace dae {
 
 		if (m_pTechnique)
 			m_pTechnique->Release();
+#endif
 
 		delete m_pDiffuseTexture; 
 		delete m_pNormalTexture;
 		delete m_pSpecularTexture;
 		delete m_pGlossinessTexture;
+		delete m_pMaterialTexture;
 
+#if ENABLE_DIRECTX
 		delete m_pEffect;
+#endif
 		
 	}
 
 
+#if ENABLE_DIRECTX
 	void Mesh::Render(ID3D11DeviceContext* pDeviceContext, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix,const Vector3& cameraPos, const FilteringMethod& filteringMethod,  ID3D11RasterizerState* pRasterizerState)
 
 	{
@@ -176,6 +193,7 @@ namespace dae {
 		}
 
 	}
+#endif
 
 
 
@@ -2,9 +2,13 @@
 
 //includes
 #include "math.h"
+#include "Texture.h"
+#if ENABLE_DIRECTX
 #include "Effect.h"
 #include "EffectPartialCoverage.h"
 #include "EffectDefault.h"
+#endif
+#include "VertexBuffer.h"
 #include <cassert>
 
 namespace dae {
@@ -46,11 +50,11 @@ namespace dae {
 
 	struct MeshStruct
 	{
-		std::vector<Vertex_In> vertices{};
+		VertexBuffer_In vertices{};	// software vertices are stored as structure of arrays
 		std::vector<uint32_t> indices{};
 		PrimitiveTopology primitiveTopology{ PrimitiveTopology::TriangleStrip };
 
-		std::vector<Vertex_Out> vertices_out{};
+		VertexBuffer_Out vertices_out{};
 		Matrix worldMatrix{};
 	};
 
@@ -58,7 +62,7 @@ namespace dae {
 	class Mesh final
 	{
 	public:
-		Mesh( ID3D11Device* pDevice, const std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices,  bool isPartialCoverage );
+		Mesh( bool isPartialCoverage, const std::string& texturePath );	// textures, the software vertices live in the renderer's MeshStruct
 		~Mesh();
 
 		Mesh(const Mesh&) = delete;
@@ -66,8 +70,11 @@ namespace dae {
 		Mesh& operator=(const Mesh&) = delete;
 		Mesh& operator=(Mesh&&) noexcept = delete;
 
+#if ENABLE_DIRECTX
+		void InitializeHardware(ID3D11Device* pDevice, const std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices);	// effect, GPU textures + buffers
 		void Render(ID3D11DeviceContext* pDeviceContext, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix, const Vector3& cameraPos, 
 			const FilteringMethod& filteringMethod, ID3D11RasterizerState* pRasterizerState);
+#endif
 		
 		bool GetIsPartialCoverage() const {
 			return m_IsPartialCoverage;
@@ -85,10 +92,14 @@ namespace dae {
 		Texture* GetGlossinessTexture() const {
 			return m_pGlossinessTexture;
 		};
+		Texture* GetMaterialTexture() const {
+			return m_pMaterialTexture;
+		};
 
 	private:
 		const bool m_IsPartialCoverage;
 
+#if ENABLE_DIRECTX
 		Effect* m_pEffect = nullptr;
 		ID3DX11EffectTechnique* m_pTechnique = nullptr;
 		FilteringMethod m_FilteringMethod{}; 
@@ -98,10 +109,12 @@ namespace dae {
 		ID3D11Buffer* m_pIndexBuffer = nullptr;
 
 		uint32_t m_NumIndices{};
+#endif
 
 		Texture* m_pDiffuseTexture;
 		Texture* m_pNormalTexture;
 		Texture* m_pSpecularTexture;
 		Texture* m_pGlossinessTexture;
+		Texture* m_pMaterialTexture = nullptr;		// software: the four maps above packed into one texel
 	};
 }
\ No newline at end of file
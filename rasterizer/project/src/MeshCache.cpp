@@ -0,0 +1,155 @@
+#include "pch.h"
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "Mesh.h"
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+namespace dae
+{
+	namespace MeshCache
+	{
+		static_assert(std::is_trivially_copyable_v<Vertex_In>, "vertices are stored as a raw blob");
+
+		struct Header
+		{
+			char magic[4]{ 'D', 'A', 'E', 'M' };
+			uint32_t version{ VERSION };
+			uint32_t vertexStride{ sizeof(Vertex_In) };	// layout check
+			uint32_t flags{};							// bit 0: flipAxisAndWinding
+			uint64_t sourceSize{};
+			int64_t sourceTimestamp{};
+			uint64_t sourceHash{};
+			uint64_t vertexCount{};
+			uint64_t indexCount{};
+			Vector3 boundsMin{};
+			Vector3 boundsMax{};
+		};
+
+		// FNV-1a, 64 bit
+		static uint64_t HashBytes(const char* pData, size_t size)
+		{
+			uint64_t hash{ 14695981039346656037ull };
+			for (size_t idx{}; idx < size; ++idx)
+			{
+				hash ^= static_cast<uint8_t>(pData[idx]);
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		static bool GetSourceInfo(const std::string& sourcePath, uint64_t& size, int64_t& timestamp)
+		{
+			std::error_code error{};
+			size = std::filesystem::file_size(sourcePath, error);
+			if (error)
+				return false;
+			timestamp = static_cast<int64_t>(std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count());
+			return !error;
+		}
+
+		std::string GetCachePath(const std::string& sourcePath)
+		{
+			return sourcePath + ".meshcache";
+		}
+
+		// Written to <cache>.tmp and renamed over the cache: an interrupted write never leaves a torn cache behind
+		static bool WriteCacheFile(const std::string& cachePath, const Header& header, const std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices)
+		{
+			const std::string tempPath{ cachePath + ".tmp" };
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			file.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(Vertex_In));
+			file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+			file.close();
+
+			std::error_code error{};
+			if (file.good())
+			{
+				std::filesystem::rename(tempPath, cachePath, error);
+				if (!error)
+					return true;
+			}
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		bool Load(const std::string& sourcePath, bool flipAxisAndWinding, std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices)
+		{
+			uint64_t sourceSize{};
+			int64_t sourceTimestamp{};
+			if (!GetSourceInfo(sourcePath, sourceSize, sourceTimestamp))
+				return false;
+
+			MappedFile cacheFile{};
+			if (!cacheFile.Open(GetCachePath(sourcePath)) || cacheFile.GetSize() < sizeof(Header))
+				return false;
+
+			Header header{};
+			std::memcpy(&header, cacheFile.GetData(), sizeof(Header));
+
+			const Header expected{};
+			if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != VERSION
+				|| header.vertexStride != sizeof(Vertex_In) || header.flags != static_cast<uint32_t>(flipAxisAndWinding)
+				|| header.sourceSize != sourceSize)
+				return false;
+
+			const size_t vertexBytes = header.vertexCount * sizeof(Vertex_In);
+			const size_t indexBytes = header.indexCount * sizeof(uint32_t);
+			if (cacheFile.GetSize() != sizeof(Header) + vertexBytes + indexBytes)
+				return false;
+
+			// Timestamp moved (checkout, copy): only the content decides
+			const bool isTimestampStale{ header.sourceTimestamp != sourceTimestamp };
+			if (isTimestampStale)
+			{
+				MappedFile sourceFile{};
+				if (!sourceFile.Open(sourcePath) || HashBytes(sourceFile.GetData(), sourceFile.GetSize()) != header.sourceHash)
+					return false;
+			}
+
+			vertices.resize(header.vertexCount);
+			indices.resize(header.indexCount);
+			std::memcpy(vertices.data(), cacheFile.GetData() + sizeof(Header), vertexBytes);
+			std::memcpy(indices.data(), cacheFile.GetData() + sizeof(Header) + vertexBytes, indexBytes);
+			cacheFile.Close();
+
+			// Same content, newer file: remember the timestamp so the next start skips the hash
+			if (isTimestampStale)
+			{
+				header.sourceTimestamp = sourceTimestamp;
+				WriteCacheFile(GetCachePath(sourcePath), header, vertices, indices);
+			}
+			return true;
+		}
+
+		bool Save(const std::string& sourcePath, bool flipAxisAndWinding, const std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices)
+		{
+			Header header{};
+			if (!GetSourceInfo(sourcePath, header.sourceSize, header.sourceTimestamp))
+				return false;
+
+			MappedFile sourceFile{};
+			if (!sourceFile.Open(sourcePath))
+				return false;
+			header.sourceHash = HashBytes(sourceFile.GetData(), sourceFile.GetSize());
+
+			header.flags = static_cast<uint32_t>(flipAxisAndWinding);
+			header.vertexCount = vertices.size();
+			header.indexCount = indices.size();
+			if (!vertices.empty())
+			{
+				header.boundsMin = header.boundsMax = vertices.front().position;
+				for (const Vertex_In& vertex : vertices)
+				{
+					header.boundsMin = { std::min(header.boundsMin.x, vertex.position.x), std::min(header.boundsMin.y, vertex.position.y), std::min(header.boundsMin.z, vertex.position.z) };
+					header.boundsMax = { std::max(header.boundsMax.x, vertex.position.x), std::max(header.boundsMax.y, vertex.position.y), std::max(header.boundsMax.z, vertex.position.z) };
+				}
+			}
+
+			// Written next to the source, a failure (read-only folder) only costs the next start a parse
+			return WriteCacheFile(GetCachePath(sourcePath), header, vertices, indices);
+		}
+	}
+}
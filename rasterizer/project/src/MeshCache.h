@@ -0,0 +1,24 @@
+#pragma once
+
+//includes
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dae
+{
+	struct Vertex_In;
+
+	// Binary copy of an imported OBJ (<source>.meshcache next to it): a header + the vertex and index blobs,
+	// memory-mapped and copied out as-is instead of parsing the text again
+	namespace MeshCache
+	{
+		constexpr uint32_t VERSION{ 3 };	// bump whenever the importer output changes
+
+		std::string GetCachePath(const std::string& sourcePath);
+
+		// false when there is no cache or it is stale (source size, timestamp + content hash, version, layout or import flags changed)
+		bool Load(const std::string& sourcePath, bool flipAxisAndWinding, std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices);
+		bool Save(const std::string& sourcePath, bool flipAxisAndWinding, const std::vector<Vertex_In>& vertices, const std::vector<uint32_t>& indices);
+	}
+}
@@ -0,0 +1,153 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+#include "Mesh.h"
+
+namespace dae
+{
+	namespace MeshOptimizer
+	{
+		float ComputeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+		{
+			if (indices.size() < 3)
+				return 0.f;
+
+			// FIFO: a vertex is in the cache while fewer than cacheSize misses happened since its own
+			std::vector<size_t> missTimes(vertexCount, 0);
+			size_t missCount{};
+			for (const uint32_t vertexIdx : indices)
+			{
+				if (missTimes[vertexIdx] == 0 || missCount - missTimes[vertexIdx] >= cacheSize)
+					missTimes[vertexIdx] = ++missCount;
+			}
+			return static_cast<float>(missCount) / (indices.size() / 3);
+		}
+
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+		{
+			const size_t triangleCount = indices.size() / 3;
+			if (triangleCount == 0)
+				return;
+
+			// Vertex -> triangle adjacency
+			std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+			for (const uint32_t vertexIdx : indices)
+				++adjacencyOffsets[vertexIdx + 1];
+			for (size_t vertexIdx{}; vertexIdx < vertexCount; ++vertexIdx)
+				adjacencyOffsets[vertexIdx + 1] += adjacencyOffsets[vertexIdx];
+
+			std::vector<uint32_t> adjacency(indices.size());
+			std::vector<uint32_t> liveTriangles(vertexCount);	// not emitted yet
+			for (size_t idx{}; idx < indices.size(); ++idx)
+			{
+				const uint32_t vertexIdx = indices[idx];
+				adjacency[adjacencyOffsets[vertexIdx] + liveTriangles[vertexIdx]++] = static_cast<uint32_t>(idx / 3);
+			}
+
+			std::vector<uint32_t> cacheTimes(vertexCount, 0);
+			std::vector<bool> isEmitted(triangleCount, false);
+			std::vector<uint32_t> deadEnds{};	// recently used vertices, the next fan starts here before jumping ahead
+			std::vector<uint32_t> candidates{};
+			std::vector<uint32_t> optimized{};
+			optimized.reserve(indices.size());
+
+			uint32_t time{ cacheSize + 1 };
+			size_t cursor{};
+			int64_t fanVertex{ 0 };
+			while (fanVertex >= 0)
+			{
+				// Emit every live triangle around the fan vertex
+				candidates.clear();
+				for (uint32_t adjacencyIdx = adjacencyOffsets[fanVertex]; adjacencyIdx < adjacencyOffsets[fanVertex + 1]; ++adjacencyIdx)
+				{
+					const uint32_t triangleIdx = adjacency[adjacencyIdx];
+					if (isEmitted[triangleIdx])
+						continue;
+
+					for (size_t corner{}; corner < 3; ++corner)
+					{
+						const uint32_t vertexIdx = indices[triangleIdx * 3 + corner];
+						optimized.push_back(vertexIdx);
+						deadEnds.push_back(vertexIdx);
+						candidates.push_back(vertexIdx);
+						--liveTriangles[vertexIdx];
+						if (time - cacheTimes[vertexIdx] > cacheSize)
+							cacheTimes[vertexIdx] = time++;
+					}
+					isEmitted[triangleIdx] = true;
+				}
+
+				// Next fan: the candidate that stays in the cache while its remaining triangles get emitted, oldest first
+				fanVertex = -1;
+				int64_t bestPriority{ -1 };
+				for (const uint32_t vertexIdx : candidates)
+				{
+					if (liveTriangles[vertexIdx] == 0)
+						continue;
+
+					int64_t priority{ 0 };
+					if (time - cacheTimes[vertexIdx] + 2 * liveTriangles[vertexIdx] <= cacheSize)
+						priority = time - cacheTimes[vertexIdx];
+					if (priority > bestPriority)
+					{
+						bestPriority = priority;
+						fanVertex = vertexIdx;
+					}
+				}
+
+				// Dead end: the most recent vertex with triangles left, else the next one in input order
+				while (fanVertex < 0 && !deadEnds.empty())
+				{
+					const uint32_t vertexIdx = deadEnds.back();
+					deadEnds.pop_back();
+					if (liveTriangles[vertexIdx] > 0)
+						fanVertex = vertexIdx;
+				}
+				for (; fanVertex < 0 && cursor < vertexCount; ++cursor)
+				{
+					if (liveTriangles[cursor] > 0)
+						fanVertex = static_cast<int64_t>(cursor);
+				}
+			}
+
+			indices = std::move(optimized);
+		}
+
+		void OptimizeVertexFetch(std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices)
+		{
+			constexpr uint32_t unused{ UINT32_MAX };
+			std::vector<uint32_t> remap(vertices.size(), unused);
+			std::vector<Vertex_In> reordered{};
+			reordered.reserve(vertices.size());
+
+			for (uint32_t& vertexIdx : indices)
+			{
+				if (remap[vertexIdx] == unused)
+				{
+					remap[vertexIdx] = static_cast<uint32_t>(reordered.size());
+					reordered.push_back(vertices[vertexIdx]);
+				}
+				vertexIdx = remap[vertexIdx];
+			}
+
+			for (size_t vertexIdx{}; vertexIdx < vertices.size(); ++vertexIdx)
+			{
+				if (remap[vertexIdx] == unused)
+					reordered.push_back(vertices[vertexIdx]);
+			}
+
+			vertices = std::move(reordered);
+		}
+
+		Report Optimize(std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices)
+		{
+			Report report{};
+			report.acmrBefore = ComputeACMR(indices, vertices.size());
+
+			OptimizeVertexCache(indices, vertices.size());
+			OptimizeVertexFetch(vertices, indices);
+
+			report.acmrAfter = ComputeACMR(indices, vertices.size());
+			return report;
+		}
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+//includes
+#include <cstdint>
+#include <vector>
+
+namespace dae
+{
+	struct Vertex_In;
+
+	// Import-time reordering for the post-transform vertex cache (D3D) and for vertex fetch locality (both paths)
+	namespace MeshOptimizer
+	{
+		constexpr uint32_t VERTEX_CACHE_SIZE{ 16 };	// FIFO entries, the target of the reordering and of the ACMR report
+
+		struct Report
+		{
+			float acmrBefore{};	// average cache miss ratio: transformed vertices per triangle (0.5 ideal, 3 worst)
+			float acmrAfter{};
+		};
+
+		float ComputeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+		// Tipsify (Sander et al. 2007): fans around the most recently cached vertex, triangle winding is kept
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+		// Vertices in order of first use, unreferenced ones at the end
+		void OptimizeVertexFetch(std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices);
+
+		Report Optimize(std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices);
+	}
+}
@@ -0,0 +1,311 @@
+#include "pch.h"
+#include "ParallelObjParser.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "Utils.h"
+
+namespace dae
+{
+	namespace ParallelObjParser
+	{
+		// A face as read: its corners + the element counts of the chunk at that line,
+		// those resolve negative indices (and reject forward references) exactly like the serial parser does
+		struct ChunkFace
+		{
+			uint32_t firstCorner{};
+			uint32_t cornerCount{};
+			uint32_t positionCount{};
+			uint32_t uvCount{};
+			uint32_t normalCount{};
+		};
+
+		struct Chunk
+		{
+			const char* pBegin{};
+			const char* pEnd{};
+
+			// Records
+			std::vector<Vector3> positions{};
+			std::vector<Vector2> UVs{};
+			std::vector<Vector3> normals{};
+			std::vector<Utils::ObjFaceCorner> faceCorners{};
+			std::vector<ChunkFace> faces{};
+			size_t positionBase{};
+			size_t uvBase{};
+			size_t normalBase{};
+
+			// Unique corners in order of first use + the triangles indexing them
+			std::vector<Utils::ObjCorner> corners{};
+			std::vector<uint32_t> indices{};
+			std::vector<std::vector<uint32_t>> shardCorners{};	// corner ids per deduplication shard
+			size_t indexBase{};
+
+			// Global vertices: a corner either is a new vertex of this chunk or was already used by an earlier chunk
+			std::vector<uint64_t> firstUses{};		// (chunk << 32) | corner of the first use
+			std::vector<uint32_t> vertexIds{};
+			size_t vertexBase{};
+			size_t vertexCount{};
+
+			// Tangents of triangles that share vertices of an earlier chunk
+			std::vector<std::pair<uint32_t, Vector3>> sharedTangents{};
+		};
+
+		static void ParseRecords(Chunk& chunk)
+		{
+			const char* pEnd = chunk.pEnd;
+			for (const char* pCursor = chunk.pBegin; pCursor < pEnd; pCursor = Utils::SkipLine(pCursor, pEnd))
+			{
+				pCursor = Utils::SkipSpaces(pCursor, pEnd);
+				if (pEnd - pCursor < 2)
+					continue;
+
+				const char command = pCursor[0];
+				const char subCommand = pCursor[1];
+				if (command == 'v' && (subCommand == ' ' || subCommand == '\t'))
+				{
+					float values[3];
+					pCursor += 1;
+					if (Utils::ParseFloats(pCursor, pEnd, values, 3))
+						chunk.positions.emplace_back(values[0], values[1], values[2]);
+				}
+				else if (command == 'v' && subCommand == 't')
+				{
+					float values[2];
+					pCursor += 2;
+					if (Utils::ParseFloats(pCursor, pEnd, values, 2))
+						chunk.UVs.emplace_back(values[0], 1 - values[1]);
+				}
+				else if (command == 'v' && subCommand == 'n')
+				{
+					float values[3];
+					pCursor += 2;
+					if (Utils::ParseFloats(pCursor, pEnd, values, 3))
+						chunk.normals.emplace_back(values[0], values[1], values[2]);
+				}
+				else if (command == 'f' && (subCommand == ' ' || subCommand == '\t'))
+				{
+					ChunkFace face{ static_cast<uint32_t>(chunk.faceCorners.size()), 0,
+						static_cast<uint32_t>(chunk.positions.size()), static_cast<uint32_t>(chunk.UVs.size()), static_cast<uint32_t>(chunk.normals.size()) };
+
+					++pCursor;
+					Utils::ObjFaceCorner faceCorner{};
+					while (Utils::ParseObjFaceCorner(pCursor, pEnd, faceCorner))
+					{
+						chunk.faceCorners.push_back(faceCorner);
+						++face.cornerCount;
+						if (!faceCorner.hasIndex[0])
+							break;	// the face gets dropped at this corner, the rest of the line doesn't matter
+					}
+					chunk.faces.push_back(face);
+				}
+			}
+		}
+
+		static void ResolveFaces(Chunk& chunk, bool flipAxisAndWinding, uint32_t shardCount)
+		{
+			std::unordered_map<Utils::ObjCorner, uint32_t, Utils::ObjCornerHash> cornerIds{};
+			std::vector<uint32_t> faceVertices{};
+			for (const ChunkFace& face : chunk.faces)
+			{
+				faceVertices.clear();
+				bool isValidFace{ true };
+				for (uint32_t cornerIdx{}; cornerIdx < face.cornerCount; ++cornerIdx)
+				{
+					Utils::ObjCorner corner{};
+					if (!Utils::ResolveObjFaceCorner(chunk.faceCorners[face.firstCorner + cornerIdx],
+						chunk.positionBase + face.positionCount, chunk.uvBase + face.uvCount, chunk.normalBase + face.normalCount, corner))
+					{
+						isValidFace = false;
+						break;
+					}
+
+					const auto [it, isNew] = cornerIds.try_emplace(corner, static_cast<uint32_t>(chunk.corners.size()));
+					if (isNew)
+						chunk.corners.push_back(corner);
+					faceVertices.push_back(it->second);
+				}
+
+				if (isValidFace)
+					Utils::AppendObjFace(faceVertices, flipAxisAndWinding, chunk.indices);
+			}
+			chunk.faceCorners = {};
+			chunk.faces = {};
+
+			// Shard by the upper hash bits, the shard maps bucket by the lower ones
+			chunk.shardCorners.resize(shardCount);
+			for (uint32_t cornerIdx{}; cornerIdx < chunk.corners.size(); ++cornerIdx)
+			{
+				const uint64_t hash = Utils::ObjCornerHash{}(chunk.corners[cornerIdx]);
+				chunk.shardCorners[(hash >> 32) % shardCount].push_back(cornerIdx);
+			}
+			chunk.firstUses.resize(chunk.corners.size());
+			chunk.vertexIds.resize(chunk.corners.size());
+		}
+
+		bool Parse(const std::string& filename, std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding, JobSystem& jobSystem,
+			size_t chunkSize)
+		{
+			MappedFile file{};
+			if (!file.Open(filename))
+				return false;
+
+			vertices.clear();
+			indices.clear();
+
+			// Newline-aligned chunks
+			const char* pData = file.GetData();
+			const char* pDataEnd = pData + file.GetSize();
+			const size_t maxJobCount = size_t(jobSystem.GetThreadCount()) * CHUNKS_PER_THREAD;
+			const size_t chunkCount = chunkSize > 0 ? std::max<size_t>((file.GetSize() + chunkSize - 1) / chunkSize, 1)
+				: std::clamp<size_t>(file.GetSize() / MIN_CHUNK_SIZE, 1, maxJobCount);
+			std::vector<Chunk> chunks(chunkCount);
+			for (size_t chunkIdx{}; chunkIdx < chunkCount; ++chunkIdx)
+			{
+				Chunk& chunk = chunks[chunkIdx];
+				chunk.pBegin = chunkIdx == 0 ? pData : chunks[chunkIdx - 1].pEnd;
+				chunk.pEnd = chunkIdx + 1 == chunkCount ? pDataEnd
+					: Utils::SkipLine(std::max(chunk.pBegin, pData + file.GetSize() * (chunkIdx + 1) / chunkCount), pDataEnd);
+			}
+			const uint32_t jobCount = static_cast<uint32_t>(chunkCount);
+			const uint32_t shardCount = static_cast<uint32_t>(std::min(chunkCount, maxJobCount));	// every chunk keeps a corner list per shard
+
+			// 1. Records, element counts are chunk local
+			jobSystem.ParallelFor(jobCount, [&](uint32_t chunkIdx) { ParseRecords(chunks[chunkIdx]); });
+
+			size_t positionCount{}, uvCount{}, normalCount{};
+			for (Chunk& chunk : chunks)
+			{
+				chunk.positionBase = positionCount;
+				chunk.uvBase = uvCount;
+				chunk.normalBase = normalCount;
+				positionCount += chunk.positions.size();
+				uvCount += chunk.UVs.size();
+				normalCount += chunk.normals.size();
+			}
+
+			// 2. Global element arrays + faces -> chunk local vertices and triangles
+			std::vector<Vector3> positions(positionCount);
+			std::vector<Vector2> UVs(uvCount);
+			std::vector<Vector3> normals(normalCount);
+			jobSystem.ParallelFor(jobCount, [&](uint32_t chunkIdx)
+				{
+					Chunk& chunk = chunks[chunkIdx];
+					std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase);
+					std::copy(chunk.UVs.begin(), chunk.UVs.end(), UVs.begin() + chunk.uvBase);
+					std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase);
+					chunk.positions = {};
+					chunk.UVs = {};
+					chunk.normals = {};
+
+					ResolveFaces(chunk, flipAxisAndWinding, shardCount);
+				});
+
+			// 3. Deduplicate across chunks: every shard walks its corners in file order, so the first use it keeps is the global first use
+			jobSystem.ParallelFor(shardCount, [&](uint32_t shardIdx)
+				{
+					std::unordered_map<Utils::ObjCorner, uint64_t, Utils::ObjCornerHash> firstUses{};
+					for (uint32_t chunkIdx{}; chunkIdx < jobCount; ++chunkIdx)
+					{
+						Chunk& chunk = chunks[chunkIdx];
+						for (const uint32_t cornerIdx : chunk.shardCorners[shardIdx])
+						{
+							const auto [it, isNew] = firstUses.try_emplace(chunk.corners[cornerIdx], (uint64_t(chunkIdx) << 32) | cornerIdx);
+							chunk.firstUses[cornerIdx] = it->second;
+						}
+					}
+				});
+
+			// 4. Global vertex ids: the first uses of a chunk are numbered in order, after those of the earlier chunks
+			jobSystem.ParallelFor(jobCount, [&](uint32_t chunkIdx)
+				{
+					Chunk& chunk = chunks[chunkIdx];
+					chunk.shardCorners = {};
+					for (uint32_t cornerIdx{}; cornerIdx < chunk.corners.size(); ++cornerIdx)
+					{
+						if (chunk.firstUses[cornerIdx] == ((uint64_t(chunkIdx) << 32) | cornerIdx))
+							chunk.vertexIds[cornerIdx] = static_cast<uint32_t>(chunk.vertexCount++);
+					}
+				});
+
+			size_t vertexCount{}, indexCount{};
+			for (Chunk& chunk : chunks)
+			{
+				chunk.vertexBase = vertexCount;
+				chunk.indexBase = indexCount;
+				vertexCount += chunk.vertexCount;
+				indexCount += chunk.indices.size();
+			}
+			vertices.resize(vertexCount);
+			indices.resize(indexCount);
+
+			jobSystem.ParallelFor(jobCount, [&](uint32_t chunkIdx)
+				{
+					Chunk& chunk = chunks[chunkIdx];
+					for (uint32_t cornerIdx{}; cornerIdx < chunk.corners.size(); ++cornerIdx)
+					{
+						if (chunk.firstUses[cornerIdx] != ((uint64_t(chunkIdx) << 32) | cornerIdx))
+							continue;
+						chunk.vertexIds[cornerIdx] += static_cast<uint32_t>(chunk.vertexBase);
+						vertices[chunk.vertexIds[cornerIdx]] = Utils::MakeObjVertex(chunk.corners[cornerIdx], positions, UVs, normals);
+					}
+				});
+
+			// Corners used before only look up ids of earlier chunks
+			jobSystem.ParallelFor(jobCount, [&](uint32_t chunkIdx)
+				{
+					Chunk& chunk = chunks[chunkIdx];
+					for (uint32_t cornerIdx{}; cornerIdx < chunk.corners.size(); ++cornerIdx)
+					{
+						const uint64_t firstUse = chunk.firstUses[cornerIdx];
+						if (firstUse != ((uint64_t(chunkIdx) << 32) | cornerIdx))
+							chunk.vertexIds[cornerIdx] = chunks[firstUse >> 32].vertexIds[firstUse & UINT32_MAX];
+					}
+
+					for (size_t idx{}; idx < chunk.indices.size(); ++idx)
+						indices[chunk.indexBase + idx] = chunk.vertexIds[chunk.indices[idx]];
+				});
+
+			// 5. Tangents: a chunk owns its new vertices and adds straight into them,
+			// a vertex is never used before its owner so adding the rest in chunk order afterwards keeps the serial summation order
+			jobSystem.ParallelFor(jobCount, [&](uint32_t chunkIdx)
+				{
+					Chunk& chunk = chunks[chunkIdx];
+					chunk.corners = {};
+					chunk.firstUses = {};
+					chunk.vertexIds = {};
+
+					const size_t indexEnd = chunk.indexBase + chunk.indices.size();
+					for (size_t i = chunk.indexBase; i < indexEnd; i += 3)
+					{
+						Vector3 tangent{};
+						if (!Utils::ComputeTriangleTangent(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]], tangent))
+							continue;
+
+						for (size_t corner{}; corner < 3; ++corner)
+						{
+							const uint32_t vertexIdx = indices[i + corner];
+							if (vertexIdx >= chunk.vertexBase)
+								vertices[vertexIdx].tangent += tangent;
+							else
+								chunk.sharedTangents.emplace_back(vertexIdx, tangent);
+						}
+					}
+				});
+
+			for (Chunk& chunk : chunks)
+			{
+				for (const auto& [vertexIdx, tangent] : chunk.sharedTangents)
+					vertices[vertexIdx].tangent += tangent;
+			}
+
+			jobSystem.ParallelFor(jobCount, [&](uint32_t chunkIdx)
+				{
+					const Chunk& chunk = chunks[chunkIdx];
+					for (size_t vertexIdx = chunk.vertexBase; vertexIdx < chunk.vertexBase + chunk.vertexCount; ++vertexIdx)
+						Utils::FinalizeObjVertex(vertices[vertexIdx], flipAxisAndWinding);
+				});
+
+			return true;
+		}
+	}
+}
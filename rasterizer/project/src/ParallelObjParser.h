@@ -0,0 +1,26 @@
+#pragma once
+
+//includes
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dae
+{
+	struct Vertex_In;
+	class JobSystem;
+
+	// Utils::ParseOBJ spread over the job system, for big assets: the mapped file is cut into newline-aligned chunks that are
+	// parsed, deduplicated and tangent-accumulated in parallel, only the per-chunk bookkeeping in between is serial.
+	// The result is identical to Utils::ParseOBJ (same vertex order, same indices, tangents summed in the same order)
+	namespace ParallelObjParser
+	{
+		constexpr size_t MIN_FILE_SIZE{ 1 << 20 };		// below this, waking the workers and merging costs more than it saves
+		constexpr size_t MIN_CHUNK_SIZE{ 128 << 10 };
+		constexpr uint32_t CHUNKS_PER_THREAD{ 4 };		// vertex records parse faster than faces, smaller chunks balance that out
+
+		// chunkSize forces chunks of about that many bytes (any count, for checking the chunk seams), 0 = sized for the thread count
+		bool Parse(const std::string& filename, std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding, JobSystem& jobSystem,
+			size_t chunkSize = 0);
+	}
+}
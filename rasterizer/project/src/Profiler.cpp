@@ -0,0 +1,243 @@
+#include "pch.h"
+#include "Profiler.h"
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <string_view>
+
+namespace dae
+{
+	Profiler::Profiler(size_t frameCapacity)
+	{
+		SetFrameCapacity(frameCapacity);
+	}
+
+	void Profiler::BeginFrame()
+	{
+		m_CurrentFrame = {};
+		m_CurrentFrame.frameIdx = m_FrameIdx;
+		m_FrameStart = ProfileClock::now();
+	}
+
+	void Profiler::EndFrame()
+	{
+		const ProfileClock::time_point frameEnd = ProfileClock::now();
+		StageMs(ProfileStage::Frame) = std::chrono::duration<double, std::milli>(frameEnd - m_FrameStart).count();
+		if (m_IsTracing)
+		{
+			AddTraceEvent("frame", "frame", m_FrameStart, frameEnd, static_cast<int64_t>(m_FrameIdx));
+			if (--m_TraceFramesLeft == 0 && !StopTrace())
+				std::cout << "Profiler: could not write " << m_TracePath << '\n';
+		}
+
+		m_Frames[m_NextFrame] = m_CurrentFrame;
+		m_NextFrame = (m_NextFrame + 1) % m_Frames.size();
+		m_FrameCount = std::min(m_FrameCount + 1, m_Frames.size());
+		++m_FrameIdx;
+	}
+
+	void Profiler::Clear()
+	{
+		m_NextFrame = 0;
+		m_FrameCount = 0;
+	}
+
+	void Profiler::SetFrameCapacity(size_t frameCapacity)
+	{
+		m_Frames.assign(std::max<size_t>(frameCapacity, 1), ProfileFrame{});
+		Clear();
+	}
+
+	void Profiler::StartTrace(const std::string& path, int frameCount)
+	{
+		m_TracePath = path;
+		m_TraceFramesLeft = std::max(frameCount, 1);
+		m_TraceThreadIdx = GetThreadIdx();
+		m_TraceStart = ProfileClock::now();
+		m_TraceEvents.clear();
+		m_TraceEvents.reserve(static_cast<size_t>(m_TraceFramesLeft) * 1024);
+		m_IsTracing = true;
+	}
+
+	bool Profiler::StopTrace()
+	{
+		if (!m_IsTracing)
+			return true;
+
+		m_IsTracing = false;
+		const bool isWritten = WriteTrace(m_TracePath);
+		if (isWritten)
+			std::cout << "Profiler: trace of " << m_TraceEvents.size() << " events written to " << m_TracePath << '\n';
+		m_TraceEvents = {};
+		return isWritten;
+	}
+
+	void Profiler::AddTraceEvent(const char* name, const char* category, ProfileClock::time_point begin, ProfileClock::time_point end, int64_t arg)
+	{
+		TraceEvent event{ name, category, GetThreadIdx(), arg,
+			std::chrono::duration<double, std::micro>(begin - m_TraceStart).count(),
+			std::chrono::duration<double, std::micro>(end - m_TraceStart).count() };
+
+		std::lock_guard lock{ m_TraceMutex };
+		m_TraceEvents.push_back(event);
+	}
+
+	uint32_t Profiler::GetThreadIdx()
+	{
+		static std::atomic<uint32_t> nextThreadIdx{};
+		thread_local const uint32_t threadIdx = nextThreadIdx.fetch_add(1);
+		return threadIdx;
+	}
+
+	// Trace event format (JSON object form): one complete event ("X") per span, named threads, opens in Perfetto and chrome://tracing
+	bool Profiler::WriteTrace(const std::string& path) const
+	{
+		std::ofstream file(path);
+		if (!file)
+			return false;
+
+		std::vector<uint32_t> threadIndices{};
+		for (const TraceEvent& event : m_TraceEvents)
+		{
+			if (std::find(threadIndices.begin(), threadIndices.end(), event.threadIdx) == threadIndices.end())
+				threadIndices.push_back(event.threadIdx);
+		}
+		std::sort(threadIndices.begin(), threadIndices.end());
+
+		file << std::fixed << std::setprecision(3);
+		file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+		file << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << m_TraceThreadIdx << ", \"args\": {\"name\": \"Renderer\"}}";
+		for (const uint32_t threadIdx : threadIndices)
+		{
+			const std::string threadName = threadIdx == m_TraceThreadIdx ? "render thread" : "worker " + std::to_string(threadIdx);
+			file << ",\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << threadIdx << ", \"args\": {\"name\": \"" << threadName << "\"}}";
+		}
+
+		for (const TraceEvent& event : m_TraceEvents)
+		{
+			file << ",\n  {\"name\": \"" << event.name << "\", \"cat\": \"" << event.category << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.threadIdx
+				<< ", \"ts\": " << event.beginUs << ", \"dur\": " << event.endUs - event.beginUs;
+			if (event.arg >= 0)
+				file << ", \"args\": {\"" << (std::string_view{ event.category } == "frame" ? "frame" : "tile") << "\": " << event.arg << '}';
+			file << '}';
+		}
+		file << "\n]}\n";
+
+		return true;
+	}
+
+	const ProfileFrame& Profiler::GetFrame(size_t idx) const
+	{
+		return m_Frames[(m_NextFrame + m_Frames.size() - m_FrameCount + idx) % m_Frames.size()];
+	}
+
+	ProfileFrame Profiler::GetAverage() const
+	{
+		ProfileFrame average{};
+		if (m_FrameCount == 0)
+			return average;
+
+		for (size_t idx{}; idx < m_FrameCount; ++idx)
+		{
+			const ProfileFrame& frame = GetFrame(idx);
+			for (size_t stageIdx{}; stageIdx < PROFILE_STAGE_COUNT; ++stageIdx)
+				average.stageMs[stageIdx] += frame.stageMs[stageIdx];
+			for (size_t counterIdx{}; counterIdx < PROFILE_COUNTER_COUNT; ++counterIdx)
+				average.counters[counterIdx] += frame.counters[counterIdx];
+		}
+
+		average.frameIdx = GetFrame(m_FrameCount - 1).frameIdx;
+		for (double& stageMs : average.stageMs)
+			stageMs /= m_FrameCount;
+		for (uint64_t& counter : average.counters)
+			counter /= m_FrameCount;
+		return average;
+	}
+
+	bool Profiler::WriteCSV(const std::string& path) const
+	{
+		std::ofstream file(path);
+		if (!file)
+			return false;
+
+		file << "frame";
+		for (size_t stageIdx{}; stageIdx < PROFILE_STAGE_COUNT; ++stageIdx)
+			file << ',' << GetName(static_cast<ProfileStage>(stageIdx)) << "Ms";
+		for (size_t counterIdx{}; counterIdx < PROFILE_COUNTER_COUNT; ++counterIdx)
+			file << ',' << GetName(static_cast<ProfileCounter>(counterIdx));
+		file << '\n';
+
+		for (size_t idx{}; idx < m_FrameCount; ++idx)
+		{
+			const ProfileFrame& frame = GetFrame(idx);
+			file << frame.frameIdx;
+			for (const double stageMs : frame.stageMs)
+				file << ',' << stageMs;
+			for (const uint64_t counter : frame.counters)
+				file << ',' << counter;
+			file << '\n';
+		}
+
+		return true;
+	}
+
+	// {"frames": [{"frame": 0, "ms": {"frame": 12.5, ...}, "counters": {"trianglesIn": 1234, ...}}, ...]}
+	bool Profiler::WriteJSON(const std::string& path) const
+	{
+		std::ofstream file(path);
+		if (!file)
+			return false;
+
+		file << "{\"frames\": [";
+		for (size_t idx{}; idx < m_FrameCount; ++idx)
+		{
+			const ProfileFrame& frame = GetFrame(idx);
+			file << (idx == 0 ? "\n" : ",\n") << "  {\"frame\": " << frame.frameIdx << ", \"ms\": {";
+			for (size_t stageIdx{}; stageIdx < PROFILE_STAGE_COUNT; ++stageIdx)
+				file << (stageIdx == 0 ? "" : ", ") << '"' << GetName(static_cast<ProfileStage>(stageIdx)) << "\": " << frame.stageMs[stageIdx];
+			file << "}, \"counters\": {";
+			for (size_t counterIdx{}; counterIdx < PROFILE_COUNTER_COUNT; ++counterIdx)
+				file << (counterIdx == 0 ? "" : ", ") << '"' << GetName(static_cast<ProfileCounter>(counterIdx)) << "\": " << frame.counters[counterIdx];
+			file << "}}";
+		}
+		file << "\n]}\n";
+
+		return true;
+	}
+
+	bool Profiler::Write(const std::string& path) const
+	{
+		const bool isJSON = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+		return isJSON ? WriteJSON(path) : WriteCSV(path);
+	}
+
+	const char* Profiler::GetName(ProfileStage stage)
+	{
+		switch (stage)
+		{
+		case ProfileStage::Frame:			return "frame";
+		case ProfileStage::VertexTransform:	return "vertexTransform";
+		case ProfileStage::TriangleSetup:	return "triangleSetup";
+		case ProfileStage::Rasterization:	return "rasterization";
+		case ProfileStage::Shading:			return "shading";
+		case ProfileStage::Blit:			return "blit";
+		case ProfileStage::Present:			return "present";
+		default:							return "unknown";
+		}
+	}
+
+	const char* Profiler::GetName(ProfileCounter counter)
+	{
+		switch (counter)
+		{
+		case ProfileCounter::TrianglesIn:			return "trianglesIn";
+		case ProfileCounter::TrianglesCulled:		return "trianglesCulled";
+		case ProfileCounter::TrianglesRasterized:	return "trianglesRasterized";
+		case ProfileCounter::FragmentsTested:		return "fragmentsTested";
+		case ProfileCounter::FragmentsShaded:		return "fragmentsShaded";
+		case ProfileCounter::TextureSamples:		return "textureSamples";
+		default:									return "unknown";
+		}
+	}
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+//includes
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dae
+{
+	using ProfileClock = std::chrono::high_resolution_clock;
+
+	// Timed parts of a frame
+	enum class ProfileStage
+	{
+		Frame,				// all of Renderer::Render (wall time)
+		VertexTransform,	// software vertex shader (wall time)
+		TriangleSetup,		// culling, clipping, setup + binning (wall time)
+		Rasterization,		// tile jobs: coverage, depth test + forward shading (thread time, summed over the tiles)
+		Shading,			// tile jobs: deferred shading, resolve, transparency + depth visualization (thread time, summed over the tiles)
+		Blit,				// SDL_BlitSurface + SDL_UpdateWindowSurface
+		Present,			// IDXGISwapChain::Present
+		Count
+	};
+
+	// Work done in a frame (software rasterizer)
+	enum class ProfileCounter
+	{
+		TrianglesIn,			// submitted
+		TrianglesCulled,		// backface, zero area or offscreen
+		TrianglesRasterized,	// binned, after clipping
+		FragmentsTested,		// covered pixels that went through the depth test
+		FragmentsShaded,		// PixelShading calls + blended fragments
+		TextureSamples,			// filtered texture fetches
+		Count
+	};
+
+	constexpr size_t PROFILE_STAGE_COUNT{ static_cast<size_t>(ProfileStage::Count) };
+	constexpr size_t PROFILE_COUNTER_COUNT{ static_cast<size_t>(ProfileCounter::Count) };
+
+	struct ProfileFrame
+	{
+		uint64_t frameIdx{};
+		std::array<double, PROFILE_STAGE_COUNT> stageMs{};
+		std::array<uint64_t, PROFILE_COUNTER_COUNT> counters{};
+	};
+
+	// One timed span of a trace (Chrome trace event format, written as a complete event)
+	struct TraceEvent
+	{
+		const char* name{};		// string literals only
+		const char* category{};
+		uint32_t threadIdx{};
+		int64_t arg{ -1 };		// frame or tile index, -1 = none
+		double beginUs{};		// since the trace started
+		double endUs{};
+	};
+
+	// Always-on frame profiler: stage times + counters of the current frame, the last frames kept in a ring buffer.
+	// Only touched from the thread calling Render, tile jobs time into their own tile and get summed afterwards.
+	// Optionally records a trace of the next frames (frame, stage and tile job spans of every thread) for Perfetto / chrome://tracing,
+	// the only part that is thread safe
+	class Profiler final
+	{
+	public:
+		// Constructor + Destructor
+		// ------
+		explicit Profiler(size_t frameCapacity = 256);
+		~Profiler() = default;
+
+		// Rule of 5
+		// ------
+		Profiler(const Profiler&) = delete;
+		Profiler(Profiler&&) noexcept = delete;
+		Profiler& operator=(const Profiler&) = delete;
+		Profiler& operator=(Profiler&&) noexcept = delete;
+
+
+		// Member Functions
+		// ------
+		void BeginFrame();
+		void EndFrame();	// current frame -> ring buffer (overwrites the oldest one when full)
+		void Clear();
+		void SetFrameCapacity(size_t frameCapacity);	// clears
+
+		void StartTrace(const std::string& path, int frameCount);	// records the next frameCount frames, then writes the trace to path
+		bool StopTrace();	// writes what got recorded so far, false when the file can't be written
+		bool IsTracing() const { return m_IsTracing; };
+		void AddTraceEvent(const char* name, const char* category, ProfileClock::time_point begin, ProfileClock::time_point end, int64_t arg = -1);	// any thread
+
+		double& StageMs(ProfileStage stage) { return m_CurrentFrame.stageMs[static_cast<size_t>(stage)]; };
+		uint64_t& Counter(ProfileCounter counter) { return m_CurrentFrame.counters[static_cast<size_t>(counter)]; };
+
+		bool WriteCSV(const std::string& path) const;
+		bool WriteJSON(const std::string& path) const;
+		bool Write(const std::string& path) const;	// .json -> JSON, anything else CSV
+
+		// Getter func
+		size_t GetFrameCount() const { return m_FrameCount; };
+		const ProfileFrame& GetFrame(size_t idx) const;	// 0 = oldest frame in the ring buffer
+		ProfileFrame GetAverage() const;	// over the ring buffer
+
+		static const char* GetName(ProfileStage stage);
+		static const char* GetName(ProfileCounter counter);
+
+	private:
+		std::vector<ProfileFrame> m_Frames;
+		size_t m_NextFrame{};
+		size_t m_FrameCount{};
+
+		ProfileFrame m_CurrentFrame{};
+		uint64_t m_FrameIdx{};
+		ProfileClock::time_point m_FrameStart{};
+
+		// trace
+		static uint32_t GetThreadIdx();	// small id per thread, in order of first use
+		bool WriteTrace(const std::string& path) const;
+
+		bool m_IsTracing{ false };	// only changes between frames, the job system synchronizes it with the workers
+		std::string m_TracePath{};
+		int m_TraceFramesLeft{};
+		uint32_t m_TraceThreadIdx{};	// the one calling Render
+		ProfileClock::time_point m_TraceStart{};
+		std::mutex m_TraceMutex;
+		std::vector<TraceEvent> m_TraceEvents;
+	};
+
+	// Adds the time until the end of the scope to a stage of the current frame or any other accumulator (per tile),
+	// and records it as a trace event while tracing
+	class ProfileScope final
+	{
+	public:
+		// Constructor + Destructor
+		// ------
+		ProfileScope(Profiler& profiler, ProfileStage stage) :
+			ProfileScope(profiler, &profiler.StageMs(stage), Profiler::GetName(stage), "stage", -1)
+		{
+		}
+		ProfileScope(Profiler& profiler, double& targetMs, const char* name, int64_t arg = -1) :
+			ProfileScope(profiler, &targetMs, name, "tile", arg)
+		{
+		}
+		ProfileScope(Profiler& profiler, const char* name, const char* category, int64_t arg = -1) :	// trace only
+			ProfileScope(profiler, nullptr, name, category, arg)
+		{
+		}
+		~ProfileScope()
+		{
+			const ProfileClock::time_point end = ProfileClock::now();
+			if (m_pTargetMs)
+				*m_pTargetMs += std::chrono::duration<double, std::milli>(end - m_Start).count();
+			if (m_Profiler.IsTracing())
+				m_Profiler.AddTraceEvent(m_Name, m_Category, m_Start, end, m_Arg);
+		}
+
+		// Rule of 5
+		// ------
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope(ProfileScope&&) noexcept = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+		ProfileScope& operator=(ProfileScope&&) noexcept = delete;
+
+	private:
+		ProfileScope(Profiler& profiler, double* pTargetMs, const char* name, const char* category, int64_t arg) :
+			m_Profiler{ profiler },
+			m_pTargetMs{ pTargetMs },
+			m_Name{ name },
+			m_Category{ category },
+			m_Arg{ arg },
+			m_Start{ ProfileClock::now() }
+		{
+		}
+
+		Profiler& m_Profiler;
+		double* m_pTargetMs;
+		const char* m_Name;
+		const char* m_Category;
+		int64_t m_Arg;
+		const ProfileClock::time_point m_Start;
+	};
+}
@@ -1,19 +1,28 @@
 #include "pch.h"
 #include "Renderer.h"
 #include "Utils.h"
+#include <bit>
 
 namespace dae {
 
-	Renderer::Renderer(SDL_Window* pWindow) :
+	// 1, 2, 4 or 8 samples per pixel (rounded down)
+	static int GetSupportedSampleCount(int sampleCount)
+	{
+		return static_cast<int>(std::bit_floor(static_cast<uint32_t>(std::clamp(sampleCount, 1, MAX_SAMPLE_COUNT))));
+	}
+
+	Renderer::Renderer(SDL_Window* pWindow, int sampleCount) :
 		m_pWindow(pWindow)
 	{
 		//Initialize
 		SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
+		m_SampleCount = GetSupportedSampleCount(sampleCount);
 
 
 		// HARDWARE
 		//===========	
 
+#if ENABLE_DIRECTX
 		//Initialize DirectX pipeline
 		const HRESULT result = InitializeDirectX();
 		if (result == S_OK)
@@ -22,6 +31,7 @@ namespace dae {
 			//std::cout << "DirectX is initialized and ready!\n";
 		}
 		else std::cout << "DirectX initialization failed!\n";
+#endif
 
 
 		// SOFTWARE
@@ -29,42 +39,105 @@ namespace dae {
 
 		// Create Buffers
 		m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
-		m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
-		m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
-		for (int index{}; index < m_Width * m_Height; ++index)  // depth-buffer
-			m_DepthBuffer.push_back(FLT_MAX);
-
+		InitializeSoftwareBuffers();
+		m_pJobSystem = std::make_unique<JobSystem>();
 
+		// Initialise Camera + Meshes
+		m_Camera.Initialize(45.f, { 0.f,0.f,0.f }, m_Width / static_cast<float>(m_Height));
+		InitializeMeshes("Kart");
+	}
 
+	Renderer::Renderer(int width, int height, const std::string& meshName, uint32_t threadCount, int sampleCount) :
+		m_IsSoftwareRasterizer{ true },
+		m_IsRotating{ false },
+		m_Width{ width },
+		m_Height{ height },
+		m_IsHeadless{ true }
+	{
+		// HEADLESS: no window, no DirectX -> only the software pipeline renders into an offscreen back buffer
+		m_SampleCount = GetSupportedSampleCount(sampleCount);
+		InitializeSoftwareBuffers();
+		m_pJobSystem = std::make_unique<JobSystem>(threadCount);
 
-		// Initialise Camera
 		m_Camera.Initialize(45.f, { 0.f,0.f,0.f }, m_Width / static_cast<float>(m_Height));
-	
-		// Initialise Mesh	
+		InitializeMeshes(meshName);
+	}
+
+	void Renderer::InitializeSoftwareBuffers()
+	{
+		m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
+		m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
+		m_BackBufferLayout = { m_pBackBuffer->format->Rshift, m_pBackBuffer->format->Gshift, m_pBackBuffer->format->Bshift, m_pBackBuffer->format->Amask };
+
+		// Multisampling: every per sample buffer holds one plane per sample
+		m_SamplePlaneSize = static_cast<size_t>(m_Width) * m_Height;
+		const SamplePosition* pSamplePattern = GetSamplePattern(m_SampleCount);
+		for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+		{
+			m_SampleOffsetX[sampleIdx] = static_cast<float>(pSamplePattern[sampleIdx].x) / SAMPLE_POSITION_SCALE;
+			m_SampleOffsetY[sampleIdx] = static_cast<float>(pSamplePattern[sampleIdx].y) / SAMPLE_POSITION_SCALE;
+		}
+		if (m_SampleCount > 1)
+			m_SampleColorBuffer.resize(m_SamplePlaneSize * m_SampleCount);
+
+		m_DepthBuffer.assign(m_SamplePlaneSize * m_SampleCount, FLT_MAX);  // depth-buffer
+		m_VisibilityBuffer.assign(m_SamplePlaneSize * m_SampleCount, NO_TRIANGLE);
+		m_OITBuffer.resize(m_Width * m_Height);
+		m_HiZWidth = (m_Width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		m_HiZBuffer.resize(m_HiZWidth * ((m_Height + BLOCK_SIZE - 1) / BLOCK_SIZE));
+
+		// Screen tiles
+		m_TileCountX = (m_Width + TILE_SIZE - 1) / TILE_SIZE;
+		const int tileCountY = (m_Height + TILE_SIZE - 1) / TILE_SIZE;
+		m_Tiles.resize(m_TileCountX * tileCountY);
+		for (int tileY{}; tileY < tileCountY; ++tileY)
+		{
+			for (int tileX{}; tileX < m_TileCountX; ++tileX)
+			{
+				Tile& tile = m_Tiles[tileX + tileY * m_TileCountX];
+				tile.minX = tileX * TILE_SIZE;
+				tile.minY = tileY * TILE_SIZE;
+				tile.maxX = std::min(tile.minX + TILE_SIZE, m_Width);
+				tile.maxY = std::min(tile.minY + TILE_SIZE, m_Height);
+			}
+		}
+	}
+
+	void Renderer::InitializeMeshes(const std::string& meshName)
+	{
+		// Initialise Mesh	(no device when headless or built without DirectX -> meshes only get their software data)
 		Mesh* pMesh;
 		MeshStruct meshStruct;
 		std::vector<Vertex_In> vertices;	// are cleared on theyre own when parsing in utils
 		std::vector<uint32_t> indices;
 
-		bool i=Utils::ParseOBJ("resources/Kart.obj",vertices,indices);	// tuktuk parsing
-		pMesh = new Mesh(m_pDevice, vertices, indices,false);
+		Utils::LoadOBJ("resources/" + meshName + ".obj", vertices, indices, true, m_pJobSystem.get());	// tuktuk parsing
+		pMesh = new Mesh(false, "resources/" + meshName);
+#if ENABLE_DIRECTX
+		if (m_pDevice)
+			pMesh->InitializeHardware(m_pDevice, vertices, indices);
+#endif
 
-		meshStruct = MeshStruct{ vertices,indices, PrimitiveTopology::TriangleList	,{}, m_WorldMatrix };
-		for (const auto& vertex : meshStruct.vertices)
-			meshStruct.vertices_out.push_back({});
+		meshStruct = MeshStruct{ VertexBuffer_In{ vertices },indices, PrimitiveTopology::TriangleList	,{}, m_WorldMatrix };
+		meshStruct.vertices_out.Resize(meshStruct.vertices.Size());
 
 		m_MeshesStructVector.push_back(meshStruct);
 		m_pMeshesVector.push_back(pMesh);
 
-		Utils::ParseOBJ("resources/Kart_fireFX.obj", vertices, indices);	// Fire parsing
-
-		pMesh = new Mesh(m_pDevice, vertices, indices,true);
-		meshStruct = MeshStruct{ vertices,indices, PrimitiveTopology::TriangleList	,{}, m_WorldMatrix };	// make a struct
-		for (const auto& vertex : meshStruct.vertices)
-			meshStruct.vertices_out.push_back({});
+		// Only the kart comes with a fire effect
+		if (Utils::LoadOBJ("resources/" + meshName + "_fireFX.obj", vertices, indices, true, m_pJobSystem.get()))	// Fire parsing
+		{
+			pMesh = new Mesh(true, "resources/fireFX");
+#if ENABLE_DIRECTX
+			if (m_pDevice)
+				pMesh->InitializeHardware(m_pDevice, vertices, indices);
+#endif
+			meshStruct = MeshStruct{ VertexBuffer_In{ vertices },indices, PrimitiveTopology::TriangleList	,{}, m_WorldMatrix };	// make a struct
+			meshStruct.vertices_out.Resize(meshStruct.vertices.Size());
 
-		m_MeshesStructVector.push_back(meshStruct);
-		m_pMeshesVector.push_back(pMesh);
+			m_MeshesStructVector.push_back(meshStruct);
+			m_pMeshesVector.push_back(pMesh);
+		}
 
 
 		// Transform meshesStruct
@@ -79,6 +152,7 @@ namespace dae {
 
 	Renderer::~Renderer()
 	{
+#if ENABLE_DIRECTX
 		// Release state
 		if (m_pRasterizerState)
 			m_pRasterizerState->Release();
@@ -126,9 +200,23 @@ namespace dae {
 			m_pDevice->Release();
 			m_pDevice = nullptr;
 		}
+#endif
 
 		// Delete all elements in m_pMeshesVector
 		std::for_each(m_pMeshesVector.begin(), m_pMeshesVector.end(), [](Mesh* pMesh) {delete pMesh; });
+
+		// Free the software back buffer (the front buffer belongs to the window)
+		if (m_pBackBuffer)
+			SDL_FreeSurface(m_pBackBuffer);
+	}
+
+	// Software sampler memory order of every loaded texture
+	void Renderer::SetTexelLayout(TexelLayout texelLayout)
+	{
+		for (const Mesh* pMesh : m_pMeshesVector)
+			for (Texture* pTexture : { pMesh->GetDiffuseTexture(), pMesh->GetNormalTexture(), pMesh->GetSpecularTexture(), pMesh->GetGlossinessTexture(), pMesh->GetMaterialTexture() })
+				if (pTexture)
+					pTexture->SetTexelLayout(texelLayout);
 	}
 
 	void Renderer::Update(const Timer* pTimer)
@@ -150,18 +238,25 @@ namespace dae {
 
 	void Renderer::Render() 
 	{
+		m_Profiler.BeginFrame();
+
 		// 1. CLEAR RTV & DSV
 		constexpr float uniformColor[4] = { .1f,.1f,.1f , 1.f };	// UNIFORM - DarkGrey
 		constexpr float softwareColor[4] = { .39f, .39f,.39f, 1.f };	//SOFTWARE - LightGrey
-		constexpr float hardwareColor[4] = { .39f,.59f,.93f , 1.f };	//HARDWARE - CornflowerBlue
 
-		if (m_IsUniformColor) m_pDeviceContext->ClearRenderTargetView(m_pRenderTargetView, uniformColor);
-		else
+#if ENABLE_DIRECTX
+		constexpr float hardwareColor[4] = { .39f,.59f,.93f , 1.f };	//HARDWARE - CornflowerBlue
+		if (m_IsInitialized)	// no DirectX when headless
 		{
-			if (!m_IsSoftwareRasterizer) m_pDeviceContext->ClearRenderTargetView(m_pRenderTargetView, hardwareColor);
-		}
+			if (m_IsUniformColor) m_pDeviceContext->ClearRenderTargetView(m_pRenderTargetView, uniformColor);
+			else
+			{
+				if (!m_IsSoftwareRasterizer) m_pDeviceContext->ClearRenderTargetView(m_pRenderTargetView, hardwareColor);
+			}
 
-		m_pDeviceContext->ClearDepthStencilView(m_pDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0);
+			m_pDeviceContext->ClearDepthStencilView(m_pDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0);
+		}
+#endif
 
 
 
@@ -176,131 +271,32 @@ namespace dae {
 			//Lock BackBuffer
 			SDL_LockSurface(m_pBackBuffer);
 
-			// clear buffers
-			SDL_FillRect(m_pBackBuffer, nullptr, SDL_MapRGB(m_pBackBuffer->format, color.r*255, color.g*255, color.b*255));
-			std::fill(m_DepthBuffer.begin(), m_DepthBuffer.end(), FLT_MAX);
-
-
-			for (int idx{}; idx<m_MeshesStructVector.size();idx++)
-			{
-				if (!m_pMeshesVector[idx]->GetIsPartialCoverage())
-				{
-					auto& mesh = m_MeshesStructVector[idx];
+			// clear values (the buffers themselves get cleared per tile)
+			m_ClearColor = m_BackBufferLayout.Pack(static_cast<uint8_t>(color.r*255), static_cast<uint8_t>(color.g*255), static_cast<uint8_t>(color.b*255));
+			m_FrameStats = {};
 
-					m_WorldViewProjectionMatrix = mesh.worldMatrix * m_Camera.GetViewMatrix() * m_Camera.GetProjectionMatrix();
-					VertexTransformationFunction(mesh.vertices, mesh.vertices_out, mesh.worldMatrix);
-
-					for (int indicesIdx{};
-						mesh.primitiveTopology == PrimitiveTopology::TriangleList ? indicesIdx < mesh.indices.size() / 3	// if it is a triangleList use this loop
-						: indicesIdx < m_MeshesStructVector[indicesIdx].indices.size() - 2;	// else (if triangleStrip) use this
-						++indicesIdx)	//for each triangle
-					{
-						// Set vertices
-						Vertex_Out v0, v1, v2;
-						if (mesh.primitiveTopology == PrimitiveTopology::TriangleList)
-						{
-							// Set Vertices
-							v0 = mesh.vertices_out[mesh.indices[indicesIdx * 3]];
-							v1 = mesh.vertices_out[mesh.indices[indicesIdx * 3 + 1]];
-							v2 = mesh.vertices_out[mesh.indices[indicesIdx * 3 + 2]];
-						}
-						else if (mesh.primitiveTopology == PrimitiveTopology::TriangleStrip)
-						{
-							// set vertices depending on even or uneven
-							if (indicesIdx % 2 == 0)
-							{
-								v0 = mesh.vertices_out[mesh.indices[indicesIdx]];
-								v1 = mesh.vertices_out[mesh.indices[indicesIdx + 1]];
-								v2 = mesh.vertices_out[mesh.indices[indicesIdx + 2]];
-							}
-							else
-							{
-								v0 = mesh.vertices_out[mesh.indices[indicesIdx]];
-								v1 = mesh.vertices_out[mesh.indices[indicesIdx + 2]];
-								v2 = mesh.vertices_out[mesh.indices[indicesIdx + 1]];
-							}
-						}
-
-
-						// BOUNDING BOX
-						int minX = std::min(v0.position.x, v1.position.x);
-						minX = std::min(minX, (int)v2.position.x) - 1;
-						if (minX < 0) minX = 0;
-						if (minX > (m_Width)) minX = m_Width;
-
-						int maxX = std::max(v0.position.x, v1.position.x);
-						maxX = std::max(maxX, (int)v2.position.x) + 1;
-						if (maxX < 0) maxX = 0;
-						if (maxX > (m_Width)) maxX = m_Width;
-
-						int minY = std::min(v0.position.y, v1.position.y);
-						minY = std::min(minY, (int)v2.position.y) - 1;
-						if (minY < 0) minY = 0;
-						if (minY > (m_Height)) minY = m_Height;
-
-						int maxY = std::max(v0.position.y, v1.position.y);
-						maxY = std::max(maxY, (int)v2.position.y) + 1;
-						if (maxY < 0) maxY = 0;
-						if (maxY > (m_Height)) maxY = m_Height;
-
-
-						// RENDERING
-						for (int px{ minX }; px < maxX; ++px)
-						{
-							for (int py{ minY }; py < maxY; ++py)
-							{
-								if (m_ShowAABBVisualization)
-								{
-									//Update Color in Buffer
-									m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-										static_cast<uint8_t>(255),
-										static_cast<uint8_t>(255),
-										static_cast<uint8_t>(255));
-								}
-								else 
-								{
-									Vector2 pixel = { px + 0.5f, py + 0.5f };	// point in middle of pixel (not top left)
-									Vertex_Out interpolatedVertex{};
-
-									if (RenderCheckPixel(pixel, v0, v1, v2, interpolatedVertex, m_pMeshesVector[idx]->GetNormalTexture()))
-									{
-
-										ColorRGB finalColor;
-
-										// Shade
-										if (m_ShowDepthVisualization)
-											finalColor = colors::White * Remap(m_DepthBuffer[px + (py * m_Width)], 0.998f, 1.f);
-										else
-											finalColor = PixelShading(interpolatedVertex,
-												m_pMeshesVector[idx]->GetDiffuseTexture(), m_pMeshesVector[idx]->GetSpecularTexture(), m_pMeshesVector[idx]->GetGlossinessTexture());
-
-										finalColor.MaxToOne();
-										//Update Color in Buffer
-										m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-											static_cast<uint8_t>(finalColor.r * 255),
-											static_cast<uint8_t>(finalColor.g * 255),
-											static_cast<uint8_t>(finalColor.b * 255));
-									}
-								}
-							}
-
-						}
-					}
-				}
-			}
+			RenderSoftware();
 
 			//@END
 			//Update SDL Surface
 			SDL_UnlockSurface(m_pBackBuffer);
-			SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-			SDL_UpdateWindowSurface(m_pWindow);
+			if (!m_IsHeadless)	// headless keeps the frame in the offscreen back buffer
+			{
+				ProfileScope blitScope{ m_Profiler, ProfileStage::Blit };
+				SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
+				SDL_UpdateWindowSurface(m_pWindow);
+			}
 
+			m_Profiler.Counter(ProfileCounter::TrianglesIn) = m_FrameStats.triangleCount;
+			m_Profiler.Counter(ProfileCounter::TrianglesCulled) = m_FrameStats.backfaceCulledCount + m_FrameStats.zeroAreaCulledCount + m_FrameStats.offscreenCulledCount;
+			m_Profiler.Counter(ProfileCounter::TrianglesRasterized) = m_BinnedTriangles.size();
+			m_Profiler.Counter(ProfileCounter::FragmentsTested) = m_FrameStats.testedPixelCount;
+			m_Profiler.Counter(ProfileCounter::FragmentsShaded) = m_FrameStats.shadedPixelCount + m_FrameStats.blendedPixelCount;
+			m_Profiler.Counter(ProfileCounter::TextureSamples) = m_FrameStats.textureSampleCount;
 		}
-		else
+#if ENABLE_DIRECTX
+		else if (m_IsInitialized)	// no hardware path when headless
 		{
-			if (!m_IsInitialized)
-				return;
-
 			// 2. SET PIPELINE + INVOKE DRAW CALLS (=RENDER)
 			Matrix worldViewProjectionMatrix = m_MeshTransformMatrix * m_Camera.GetViewMatrix() * m_Camera.GetProjectionMatrix();
 			for (auto& mesh : m_pMeshesVector)
@@ -316,8 +312,125 @@ namespace dae {
 
 
 			// 3. PRESENT BACKBUFFER (SWAP)
+			ProfileScope presentScope{ m_Profiler, ProfileStage::Present };
 			m_pSwapChain->Present(0, 0);
 		}
+#endif
+
+		m_Profiler.EndFrame();
+	}
+
+
+
+	// Picks the pipeline instantiation of the current toggles (the depth visualization doesn't shade -> one for all modes)
+	void Renderer::RenderSoftware()
+	{
+		if (m_ShowDepthVisualization)
+		{
+			RenderSoftwareFrame<SoftwarePipeline<ShadingMode::ObservedArea, false, true>>();
+			return;
+		}
+
+		switch (m_CurrentShadingMode)
+		{
+		case dae::ShadingMode::ObservedArea:
+			RenderSoftware<ShadingMode::ObservedArea>();
+			break;
+		case dae::ShadingMode::Diffuse:
+			RenderSoftware<ShadingMode::Diffuse>();
+			break;
+		case dae::ShadingMode::Specular:
+			RenderSoftware<ShadingMode::Specular>();
+			break;
+		case dae::ShadingMode::Combined:
+			RenderSoftware<ShadingMode::Combined>();
+			break;
+		}
+	}
+
+	template<ShadingMode Mode>
+	void Renderer::RenderSoftware()
+	{
+		if (m_IsNormalMapVisible)
+			RenderSoftwareFrame<SoftwarePipeline<Mode, true, false>>();
+		else
+			RenderSoftwareFrame<SoftwarePipeline<Mode, false, false>>();
+	}
+
+	template<typename Pipeline>
+	void Renderer::RenderSoftwareFrame()
+	{
+		// PROJECTION STAGE + BINNING
+		m_BinnedTriangles.clear();
+		m_ClippedVertices.Resize(0);
+		for (auto& tile : m_Tiles)
+		{
+			tile.triangleIndices.clear();
+			tile.transparentTriangleIndices.clear();
+		}
+
+		for (int idx{}; idx<static_cast<int>(m_MeshesStructVector.size());idx++)
+		{
+			auto& mesh = m_MeshesStructVector[idx];
+			m_WorldViewProjectionMatrix = mesh.worldMatrix * m_Camera.GetViewMatrix() * m_Camera.GetProjectionMatrix();
+
+			if (!m_pMeshesVector[idx]->GetIsPartialCoverage())
+			{
+				{
+					ProfileScope transformScope{ m_Profiler, ProfileStage::VertexTransform };
+					VertexTransformationFunction<Pipeline>(mesh.vertices, mesh.vertices_out, mesh.worldMatrix);
+				}
+				ProfileScope setupScope{ m_Profiler, ProfileStage::TriangleSetup };
+				BinTriangles<Pipeline>(idx);
+			}
+			else if (m_ShowFireMesh && !Pipeline::isDepthOnly)	// doesn't write depth -> nothing to visualize
+			{
+				{
+					ProfileScope transformScope{ m_Profiler, ProfileStage::VertexTransform };
+					VertexTransformationFunction<PartialCoveragePipeline>(mesh.vertices, mesh.vertices_out, mesh.worldMatrix);
+				}
+				ProfileScope setupScope{ m_Profiler, ProfileStage::TriangleSetup };
+				BinTriangles<PartialCoveragePipeline>(idx);
+			}
+		}
+
+		// RASTERIZATION STAGE (every tile owns its part of the color + depth buffer -> no locking)
+		{
+			ProfileScope tilesScope{ m_Profiler, "tileJobs", "stage" };
+			m_pJobSystem->ParallelFor(static_cast<uint32_t>(m_Tiles.size()), [this](uint32_t tileIdx)
+				{
+					ProfileScope tileScope{ m_Profiler, "tile", "tile", tileIdx };
+					RenderTile<Pipeline>(m_Tiles[tileIdx]);
+				});
+		}
+
+		// DEPTH VISUALIZATION (remap the depth range of the frame, tracked per tile, to black-white)
+		if constexpr (Pipeline::isDepthOnly)
+		{
+			float minDepth{ FLT_MAX }, maxDepth{ 0.f };
+			for (const auto& tile : m_Tiles)
+			{
+				minDepth = std::min(minDepth, tile.minDepth);
+				maxDepth = std::max(maxDepth, tile.maxDepth);
+			}
+
+			ProfileScope tilesScope{ m_Profiler, "depthTileJobs", "stage" };
+			m_pJobSystem->ParallelFor(static_cast<uint32_t>(m_Tiles.size()), [this, minDepth, maxDepth](uint32_t tileIdx)
+				{
+					ShadeDepthTile(m_Tiles[tileIdx], minDepth, maxDepth);
+				});
+		}
+
+		for (const auto& tile : m_Tiles)
+		{
+			m_FrameStats.pixelCount += tile.pixelCount;
+			m_FrameStats.shadedPixelCount += tile.shadedPixelCount;
+			m_FrameStats.blendedPixelCount += tile.blendedPixelCount;
+			m_FrameStats.testedPixelCount += tile.testedPixelCount;
+			m_FrameStats.textureSampleCount += tile.textureSampleCount;
+			m_Profiler.StageMs(ProfileStage::Rasterization) += tile.rasterizationMs;
+			m_Profiler.StageMs(ProfileStage::Shading) += tile.shadingMs;
+		}
 	}
 
 
@@ -325,6 +438,7 @@ namespace dae {
 	//	HARDWARE RASTERIZING FUNCTIONS
 	//==================================
 
+#if ENABLE_DIRECTX
 	HRESULT Renderer::InitializeDirectX()
 	{
 		//1. Create Device & DeviceContent
@@ -348,6 +462,15 @@ namespace dae {
 
 
 
+		//Highest supported sample count up to the requested one (the software rasterizer supports all of them)
+		m_HardwareSampleCount = m_SampleCount;
+		uint32_t qualityLevelCount{};
+		while (m_HardwareSampleCount > 1
+			&& (FAILED(m_pDevice->CheckMultisampleQualityLevels(DXGI_FORMAT_R8G8B8A8_UNORM, m_HardwareSampleCount, &qualityLevelCount)) || qualityLevelCount == 0))
+			m_HardwareSampleCount /= 2;
+
+
+
 		//2. Create Swapchain
 		//====
 		DXGI_SWAP_CHAIN_DESC swapChainDesc{};
@@ -358,7 +481,7 @@ namespace dae {
 		swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
 		swapChainDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
 		swapChainDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
-		swapChainDesc.SampleDesc.Count = 1;
+		swapChainDesc.SampleDesc.Count = m_HardwareSampleCount;
 		swapChainDesc.SampleDesc.Quality = 0;
 		swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
 		swapChainDesc.BufferCount = 1;
@@ -389,7 +512,7 @@ namespace dae {
 		depthStencilDesc.MipLevels = 1;
 		depthStencilDesc.ArraySize = 1;
 		depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-		depthStencilDesc.SampleDesc.Count = 1;
+		depthStencilDesc.SampleDesc.Count = m_HardwareSampleCount;	// has to match the render target
 		depthStencilDesc.SampleDesc.Quality = 0;
 		depthStencilDesc.Usage = D3D11_USAGE_DEFAULT;
 		depthStencilDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
@@ -399,7 +522,7 @@ namespace dae {
 		//View
 		D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc{};
 		depthStencilViewDesc.Format = depthStencilDesc.Format;
-		depthStencilViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+		depthStencilViewDesc.ViewDimension = m_HardwareSampleCount > 1 ? D3D11_DSV_DIMENSION_TEXTURE2DMS : D3D11_DSV_DIMENSION_TEXTURE2D;
 		depthStencilViewDesc.Texture2D.MipSlice = 0;
 
 		result = m_pDevice->CreateTexture2D(&depthStencilDesc, nullptr, &m_pDepthStencilBuffer);
@@ -449,6 +572,7 @@ namespace dae {
 		D3D11_RASTERIZER_DESC rasterizerDesc{};
 		rasterizerDesc.CullMode = D3D11_CULL_NONE;
 		rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+		rasterizerDesc.MultisampleEnable = m_HardwareSampleCount > 1;
 
 		result = m_pDevice->CreateRasterizerState(&rasterizerDesc, &m_pRasterizerState);
 
@@ -462,6 +586,7 @@ namespace dae {
 
 		return S_OK;
 	}
+#endif
 
 
 
@@ -469,178 +594,1253 @@ namespace dae {
 	//==================================
 
 	// PROJECTION STAGE (+ Rasterization stage)
-	void Renderer::VertexTransformationFunction(const std::vector<Vertex_In>& vertices_in, std::vector<Vertex_Out>& vertices_out, const Matrix& worldMatrix) const
+	template<typename Pipeline>
+	void Renderer::VertexTransformationFunction(const VertexBuffer_In& vertices_in, VertexBuffer_Out& vertices_out, const Matrix& worldMatrix) const
 	{
 		// PROJECTION STAGE
 		//========================
 		
 
 		// Resize vertex_out vector if size isnt equal
-		if (vertices_in.size() != vertices_out.size())
-			vertices_out.resize(vertices_in.size());
+		if (vertices_in.Size() != vertices_out.Size())
+			vertices_out.Resize(vertices_in.Size());
+
+		// TRANSFORMING VERTICES (chunks in parallel, SIMD_WIDTH vertices at a time within a chunk)
+		const uint32_t chunkCount = static_cast<uint32_t>((vertices_in.Size() + VERTEX_CHUNK_SIZE - 1) / VERTEX_CHUNK_SIZE);
+		m_pJobSystem->ParallelFor(chunkCount, [&](uint32_t chunkIdx)
+			{
+				const size_t begin = chunkIdx * VERTEX_CHUNK_SIZE;
+				const size_t end = std::min(begin + VERTEX_CHUNK_SIZE, vertices_in.Size());
+				TransformVertices<Pipeline>(vertices_in, vertices_out, worldMatrix, begin, end);
+			});
+	}
+
+	// Only the attributes the pipeline reads later on are written, the other streams keep stale values
+	template<typename Pipeline>
+	void Renderer::TransformVertices(const VertexBuffer_In& vertices_in, VertexBuffer_Out& vertices_out, const Matrix& worldMatrix, size_t begin, size_t end) const
+	{
+		// One register per matrix element
+		FloatV wvp[4][4];
+		FloatV world[4][3];
+		for (int row{}; row < 4; ++row)
+		{
+			for (int col{}; col < 4; ++col)
+				wvp[row][col] = FloatV(m_WorldViewProjectionMatrix[row][col]);
+			for (int col{}; col < 3; ++col)
+				world[row][col] = FloatV(worldMatrix[row][col]);
+		}
+		const FloatV cameraX{ m_Camera.origin.x }, cameraY{ m_Camera.origin.y }, cameraZ{ m_Camera.origin.z };
+		const FloatV one{ 1.f }, half{ .5f };
+		const FloatV width{ static_cast<float>(m_Width) }, height{ static_cast<float>(m_Height) };
 
-		// TRANSFORMING VERTICES
-		for (int index{}; index < vertices_in.size(); ++index)
+		// The streams are padded to whole batches -> no tail
+		for (size_t index{ begin }; index < end; index += SIMD_WIDTH)
 		{
+			const FloatV px = FloatV::Load(&vertices_in.position.x[index]);
+			const FloatV py = FloatV::Load(&vertices_in.position.y[index]);
+			const FloatV pz = FloatV::Load(&vertices_in.position.z[index]);
+
 			// Transform vertices (store depth in w value)
-			vertices_out[index].position = m_WorldViewProjectionMatrix.TransformPoint({ vertices_in[index].position.x,vertices_in[index].position.y,
-																								vertices_in[index].position.z, 1.f });
-			vertices_out[index].normal = worldMatrix.TransformVector(vertices_in[index].normal).Normalized();
-			vertices_out[index].tangent = worldMatrix.TransformVector(vertices_in[index].tangent).Normalized();
+			FloatV x = px * wvp[0][0] + py * wvp[1][0] + pz * wvp[2][0] + wvp[3][0];
+			FloatV y = px * wvp[0][1] + py * wvp[1][1] + pz * wvp[2][1] + wvp[3][1];
+			FloatV z = px * wvp[0][2] + py * wvp[1][2] + pz * wvp[2][2] + wvp[3][2];
+			const FloatV w = px * wvp[0][3] + py * wvp[1][3] + pz * wvp[2][3] + wvp[3][3];
+
+			x.Store(&vertices_out.clipPosition.x[index]);
+			y.Store(&vertices_out.clipPosition.y[index]);
+			z.Store(&vertices_out.clipPosition.z[index]);
+			w.Store(&vertices_out.clipPosition.w[index]);
 
-			if (m_CurrentShadingMode == ShadingMode::Combined || m_CurrentShadingMode == ShadingMode::Specular)
-				vertices_out[index].viewDirection = (worldMatrix.TransformPoint(vertices_in[index].position) - m_Camera.origin).Normalized();	// use the WORLD pos of the vertices
+			// Perspective divide (vertices behind the camera only end up in clipped triangles, which divide again after clipping)
+			x = x / w;
+			y = y / w;
+			z = z / w;
+
+			// NDC to SCREEN ( RASTERIZATION)
+			x = (x + one) * half * width;
+			y = (one - y) * half * height;
+
+			x.Store(&vertices_out.position.x[index]);
+			y.Store(&vertices_out.position.y[index]);
+			z.Store(&vertices_out.position.z[index]);
+			w.Store(&vertices_out.position.w[index]);
+
+			// Normal + tangent to world
+			if constexpr (Pipeline::hasNormal)
+			{
+				const FloatV normalIn[3]{ FloatV::Load(&vertices_in.normal.x[index]), FloatV::Load(&vertices_in.normal.y[index]), FloatV::Load(&vertices_in.normal.z[index]) };
+				FloatV normal[3];
+				for (int col{}; col < 3; ++col)
+					normal[col] = normalIn[0] * world[0][col] + normalIn[1] * world[1][col] + normalIn[2] * world[2][col];
+				Normalize(normal[0], normal[1], normal[2]);
+
+				normal[0].Store(&vertices_out.normal.x[index]);
+				normal[1].Store(&vertices_out.normal.y[index]);
+				normal[2].Store(&vertices_out.normal.z[index]);
+			}
+			if constexpr (Pipeline::hasTangent)
+			{
+				const FloatV tangentIn[3]{ FloatV::Load(&vertices_in.tangent.x[index]), FloatV::Load(&vertices_in.tangent.y[index]), FloatV::Load(&vertices_in.tangent.z[index]) };
+				FloatV tangent[3];
+				for (int col{}; col < 3; ++col)
+					tangent[col] = tangentIn[0] * world[0][col] + tangentIn[1] * world[1][col] + tangentIn[2] * world[2][col];
+				Normalize(tangent[0], tangent[1], tangent[2]);
+
+				tangent[0].Store(&vertices_out.tangent.x[index]);
+				tangent[1].Store(&vertices_out.tangent.y[index]);
+				tangent[2].Store(&vertices_out.tangent.z[index]);
+			}
 
 			// Carry over the other values into the out vertices
-			//vertices_out[index].color = vertices_in[index].color;
-			vertices_out[index].uv = vertices_in[index].uv;
+			if constexpr (Pipeline::hasUV)
+			{
+				FloatV::Load(&vertices_in.uv.x[index]).Store(&vertices_out.uv.x[index]);
+				FloatV::Load(&vertices_in.uv.y[index]).Store(&vertices_out.uv.y[index]);
+			}
 
+			// View direction, use the WORLD pos of the vertices
+			if constexpr (Pipeline::hasViewDirection)
+			{
+				FloatV viewX = px * world[0][0] + py * world[1][0] + pz * world[2][0] + world[3][0] - cameraX;
+				FloatV viewY = px * world[0][1] + py * world[1][1] + pz * world[2][1] + world[3][1] - cameraY;
+				FloatV viewZ = px * world[0][2] + py * world[1][2] + pz * world[2][2] + world[3][2] - cameraZ;
+				Normalize(viewX, viewY, viewZ);
+
+				viewX.Store(&vertices_out.viewDirection.x[index]);
+				viewY.Store(&vertices_out.viewDirection.y[index]);
+				viewZ.Store(&vertices_out.viewDirection.z[index]);
+			}
+		}
+	}
+	
+	// BINNING STAGE (sort the triangles into every screen tile their bounding box overlaps)
+	template<typename Pipeline>
+	void Renderer::BinTriangles(int meshIdx)
+	{
+		const auto& mesh = m_MeshesStructVector[meshIdx];
+
+		const size_t triangleCount = mesh.primitiveTopology == PrimitiveTopology::TriangleList ? mesh.indices.size() / 3	// if it is a triangleList
+			: mesh.indices.size() - 2;	// else (if triangleStrip)
+		m_FrameStats.triangleCount += static_cast<uint32_t>(triangleCount);
 
+		for (size_t triangleIdx{}; triangleIdx < triangleCount; ++triangleIdx)
+		{
+			// Set vertices
+			BinnedTriangle triangle{};
+			triangle.meshIdx = meshIdx;
+			if (mesh.primitiveTopology == PrimitiveTopology::TriangleList)
+			{
+				triangle.vertexIndices[0] = mesh.indices[triangleIdx * 3];
+				triangle.vertexIndices[1] = mesh.indices[triangleIdx * 3 + 1];
+				triangle.vertexIndices[2] = mesh.indices[triangleIdx * 3 + 2];
+			}
+			else
+			{
+				// set vertices depending on even or uneven
+				triangle.vertexIndices[0] = mesh.indices[triangleIdx];
+				triangle.vertexIndices[1] = mesh.indices[triangleIdx + (triangleIdx % 2 == 0 ? 1 : 2)];
+				triangle.vertexIndices[2] = mesh.indices[triangleIdx + (triangleIdx % 2 == 0 ? 2 : 1)];
+			}
 
-			// Perspective divide
-			if (vertices_out[index].position.w > 0.f)
+			// PRIMITIVE ASSEMBLY (whole triangles are culled before any rasterization work)
+			// Frustum culling + clipping
+			const Vector4 clipPosition0 = mesh.vertices_out.GetClipPosition(triangle.vertexIndices[0]);
+			const Vector4 clipPosition1 = mesh.vertices_out.GetClipPosition(triangle.vertexIndices[1]);
+			const Vector4 clipPosition2 = mesh.vertices_out.GetClipPosition(triangle.vertexIndices[2]);
+			const uint32_t clipCode0 = GetClipCode(clipPosition0);
+			const uint32_t clipCode1 = GetClipCode(clipPosition1);
+			const uint32_t clipCode2 = GetClipCode(clipPosition2);
+			if (clipCode0 & clipCode1 & clipCode2 & CLIP_FRUSTUM)	// all vertices outside of the same plane
 			{
-				vertices_out[index].position.x /= vertices_out[index].position.w;
-				vertices_out[index].position.y /= vertices_out[index].position.w;
-				vertices_out[index].position.z /= vertices_out[index].position.w;
+				++m_FrameStats.offscreenCulledCount;
+				continue;
 			}
 
+			if ((clipCode0 | clipCode1 | clipCode2) & CLIP_NEEDED)
+			{
+				// Face culling before clipping: the sign of the homogeneous (x, y, w) determinant is the facing,
+				// also with vertices behind the camera (negative = clockwise on screen)
+				const float determinant = clipPosition0.x * (clipPosition1.y * clipPosition2.w - clipPosition1.w * clipPosition2.y)
+					- clipPosition0.y * (clipPosition1.x * clipPosition2.w - clipPosition1.w * clipPosition2.x)
+					+ clipPosition0.w * (clipPosition1.x * clipPosition2.y - clipPosition1.y * clipPosition2.x);
+				if (determinant == 0.f)
+				{
+					++m_FrameStats.zeroAreaCulledCount;
+					continue;
+				}
+				if (IsFaceCulled(determinant < 0.f))
+				{
+					++m_FrameStats.backfaceCulledCount;
+					continue;
+				}
 
+				++m_FrameStats.clippedCount;
+				ClipTriangle<Pipeline>(triangle, clipCode0 | clipCode1 | clipCode2);
+				continue;
+			}
 
-			// RASTERIZATION STAGE
-			//========================
-		
-			// NDC to SCREEN ( RASTERIZATION)
-			VertexNDCToScreen(vertices_out[index].position);
+			switch (SetupTriangle<Pipeline>(mesh.vertices_out, triangle))
+			{
+			case TriangleCull::Visible:
+				AddToTiles(triangle);
+				break;
+			case TriangleCull::Backface:
+				++m_FrameStats.backfaceCulledCount;
+				break;
+			case TriangleCull::ZeroArea:
+				++m_FrameStats.zeroAreaCulledCount;
+				break;
+			case TriangleCull::Offscreen:
+				++m_FrameStats.offscreenCulledCount;
+				break;
+			}
 		}
 	}
-	
-	// RASTERIZATION STAGE (NDC to raster space)
-	void Renderer::VertexNDCToScreen(Vector4& vertexPosition) const
+
+	// Face culling, clockwise on screen is the front face
+	bool Renderer::IsFaceCulled(bool isClockwise) const
 	{
-		vertexPosition.x = ((vertexPosition.x + 1) / 2) * m_Width;
-		vertexPosition.y = ((1 - vertexPosition.y) / 2) * m_Height;
+		switch (m_CurrentCullMode)
+		{
+		case dae::Back:
+			return !isClockwise;
+		case dae::Front:
+			return isClockwise;
+		default:
+			return false;
+		}
 	}
-	// RASTERIZATION STAGE (Is pixel in triangle)
-	bool Renderer::RenderCheckPixel(const Vector2& pixel,
-		const Vertex_Out& vertex0, const Vertex_Out& vertex1, const Vertex_Out& vertex2,
-		Vertex_Out& interpolatedVertex, const Texture* pNormaltexture)
+
+	void Renderer::AddToTiles(const BinnedTriangle& triangle)
 	{
+		const uint32_t binnedIdx = static_cast<uint32_t>(m_BinnedTriangles.size());
+		m_BinnedTriangles.push_back(triangle);
+
+		const bool isTransparent = m_pMeshesVector[triangle.meshIdx]->GetIsPartialCoverage();
+		for (int tileY{ triangle.minY / TILE_SIZE }; tileY <= (triangle.maxY - 1) / TILE_SIZE; ++tileY)
+		{
+			for (int tileX{ triangle.minX / TILE_SIZE }; tileX <= (triangle.maxX - 1) / TILE_SIZE; ++tileX)
+			{
+				Tile& tile = m_Tiles[tileX + tileY * m_TileCountX];
+				(isTransparent ? tile.transparentTriangleIndices : tile.triangleIndices).push_back(binnedIdx);
+			}
+		}
+	}
 
-		Vector4 v0 = vertex0.position;
-		Vector4 v1 = vertex1.position;
-		Vector4 v2 = vertex2.position;
+	uint32_t Renderer::GetClipCode(const Vector4& clipPosition) const
+	{
+		// guard band in clip space: screen [-GUARD_BAND, size + GUARD_BAND]
+		const float guardBandX = (1.f + 2.f * GUARD_BAND / m_Width) * clipPosition.w;
+		const float guardBandY = (1.f + 2.f * GUARD_BAND / m_Height) * clipPosition.w;
+
+		uint32_t clipCode{};
+		if (clipPosition.x < -clipPosition.w) clipCode |= CLIP_LEFT;
+		if (clipPosition.x > clipPosition.w) clipCode |= CLIP_RIGHT;
+		if (clipPosition.y < -clipPosition.w) clipCode |= CLIP_BOTTOM;
+		if (clipPosition.y > clipPosition.w) clipCode |= CLIP_TOP;
+		if (clipPosition.z < 0.f) clipCode |= CLIP_NEAR;
+		if (clipPosition.z > clipPosition.w) clipCode |= CLIP_FAR;
+		if (clipPosition.x < -guardBandX) clipCode |= GUARD_LEFT;
+		if (clipPosition.x > guardBandX) clipCode |= GUARD_RIGHT;
+		if (clipPosition.y < -guardBandY) clipCode |= GUARD_BOTTOM;
+		if (clipPosition.y > guardBandY) clipCode |= GUARD_TOP;
+		return clipCode;
+	}
 
-		////////////////////
-		// Weights and Depth
-		////////////////////
+	// CLIPPING STAGE (Sutherland-Hodgman in clip space against near/far and the guard band, then triangulated as a fan)
+	template<typename Pipeline>
+	void Renderer::ClipTriangle(const BinnedTriangle& triangle, uint32_t clipCodes)
+	{
+		const VertexBuffer_Out& vertices = m_MeshesStructVector[triangle.meshIdx].vertices_out;
 
-		Vector2 v0ToPixel = pixel - Vector2{ v0.x, v0.y };
-		Vector2 v1ToPixel = pixel - Vector2{ v1.x, v1.y };
-		Vector2 v2ToPixel = pixel - Vector2{ v2.x, v2.y };
+		// every plane adds at most one vertex
+		constexpr int maxPolygonSize{ 3 + 6 };
+		Vertex_Out polygon[maxPolygonSize], clipped[maxPolygonSize];
+		int polygonSize{ 3 };
+		for (int idx{}; idx < 3; ++idx)
+		{
+			polygon[idx] = vertices.GetVertex(triangle.vertexIndices[idx]);
+			polygon[idx].position = vertices.GetClipPosition(triangle.vertexIndices[idx]);	// clip in clip space
+		}
 
-		// Calculate CROSS
-		float v0Weight = Vector2::Cross(Vector2{ v2.x - v1.x,v2.y - v1.y }, v1ToPixel);
-		float v1Weight = Vector2::Cross(Vector2{ v0.x - v2.x,v0.y - v2.y }, v2ToPixel);
-		float v2Weight = Vector2::Cross(Vector2{ v1.x - v0.x,v1.y - v0.y }, v0ToPixel);
-		//if (v0Weight > 0) return false;
-		//if (v1Weight > 0) return false;
-		//if (v2Weight > 0) return false;
+		// plane . position >= 0 -> inside
+		const float guardBandX = 1.f + 2.f * GUARD_BAND / m_Width;
+		const float guardBandY = 1.f + 2.f * GUARD_BAND / m_Height;
+		const Vector4 planes[6]{ { 0.f, 0.f, 1.f, 0.f }, { 0.f, 0.f, -1.f, 1.f },
+			{ 1.f, 0.f, 0.f, guardBandX }, { -1.f, 0.f, 0.f, guardBandX }, { 0.f, 1.f, 0.f, guardBandY }, { 0.f, -1.f, 0.f, guardBandY } };
+		const uint32_t planeCodes[6]{ CLIP_NEAR, CLIP_FAR, GUARD_LEFT, GUARD_RIGHT, GUARD_BOTTOM, GUARD_TOP };
 
-		// Face culling
-		switch (m_CurrentCullMode)
+		for (int planeIdx{}; planeIdx < 6; ++planeIdx)
 		{
-		case dae::None:
-			if (v0Weight > 0)
+			if (!(clipCodes & planeCodes[planeIdx]))
+				continue;
+
+			int clippedSize{};
+			for (int idx{}; idx < polygonSize; ++idx)
 			{
-				if (v1Weight < 0) return false;
-				if (v2Weight < 0) return false;
+				const Vertex_Out& current = polygon[idx];
+				const Vertex_Out& next = polygon[(idx + 1) % polygonSize];
+				const float currentDistance = Vector4::Dot(planes[planeIdx], current.position);
+				const float nextDistance = Vector4::Dot(planes[planeIdx], next.position);
+
+				if (currentDistance >= 0.f)
+					clipped[clippedSize++] = current;
+
+				if ((currentDistance >= 0.f) != (nextDistance >= 0.f))	// edge crosses the plane
+				{
+					// all attributes are linear in clip space
+					const float t = currentDistance / (currentDistance - nextDistance);
+					Vertex_Out& vertex = clipped[clippedSize++];
+					vertex.position = current.position + (next.position - current.position) * t;
+					vertex.uv = current.uv + (next.uv - current.uv) * t;
+					vertex.normal = current.normal + (next.normal - current.normal) * t;
+					vertex.tangent = current.tangent + (next.tangent - current.tangent) * t;
+					vertex.viewDirection = current.viewDirection + (next.viewDirection - current.viewDirection) * t;
+				}
 			}
-			else
+
+			std::copy_n(clipped, clippedSize, polygon);
+			polygonSize = clippedSize;
+			if (polygonSize < 3)	// nothing left
+				return;
+		}
+
+		// Perspective divide + NDC to SCREEN of the new polygon
+		const uint32_t firstIdx = static_cast<uint32_t>(m_ClippedVertices.Size());
+		for (int idx{}; idx < polygonSize; ++idx)
+		{
+			Vector4& position = polygon[idx].position;
+			position = { (position.x / position.w + 1.f) * 0.5f * m_Width, (1.f - position.y / position.w) * 0.5f * m_Height,
+				position.z / position.w, position.w };
+			m_ClippedVertices.AddVertex(polygon[idx]);
+		}
+
+		for (int idx{ 1 }; idx + 1 < polygonSize; ++idx)
+		{
+			BinnedTriangle clippedTriangle{};
+			clippedTriangle.meshIdx = triangle.meshIdx;
+			clippedTriangle.vertexIndices[0] = firstIdx;
+			clippedTriangle.vertexIndices[1] = firstIdx + idx;
+			clippedTriangle.vertexIndices[2] = firstIdx + idx + 1;
+
+			if (SetupTriangle<Pipeline>(m_ClippedVertices, clippedTriangle) == TriangleCull::Visible)
+				AddToTiles(clippedTriangle);
+		}
+	}
+
+	// TRIANGLE SETUP (edge functions, bounding box and attribute planes, once per triangle)
+	template<typename Pipeline>
+	TriangleCull Renderer::SetupTriangle(const VertexBuffer_Out& vertices, BinnedTriangle& triangle) const
+	{
+		uint32_t indices[3]{ triangle.vertexIndices[0], triangle.vertexIndices[1], triangle.vertexIndices[2] };
+
+		// Snap to the subpixel grid
+		int64_t x[3], y[3];
+		for (int idx{}; idx < 3; ++idx)
+		{
+			const float screenX = vertices.position.x[indices[idx]];
+			const float screenY = vertices.position.y[indices[idx]];
+			if (!(std::abs(screenX) < SUBPIXEL_RANGE && std::abs(screenY) < SUBPIXEL_RANGE))	// also catches NaN
+				return TriangleCull::Offscreen;
+
+			x[idx] = static_cast<int64_t>(std::lround(screenX * SUBPIXEL_SCALE));
+			y[idx] = static_cast<int64_t>(std::lround(screenY * SUBPIXEL_SCALE));
+		}
+
+		// Signed area, positive = clockwise on screen
+		int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+		if (area == 0)
+			return TriangleCull::ZeroArea;
+		if (IsFaceCulled(area > 0))
+			return TriangleCull::Backface;
+
+		// Make every triangle clockwise so the inside test is the same for all of them
+		if (area < 0)
+		{
+			std::swap(x[1], x[2]);
+			std::swap(y[1], y[2]);
+			std::swap(indices[1], indices[2]);
+			area = -area;
+		}
+
+		// BOUNDING BOX (pixels whose center, or any of their samples, can be inside)
+		const int64_t halfPixel = SUBPIXEL_SCALE / 2;
+		const int64_t sampleReach = m_SampleCount > 1 ? SUBPIXEL_SCALE / 2 : 0;	// samples lie within half a pixel of the center
+		const int64_t minXFixed = std::min({ x[0], x[1], x[2] });
+		const int64_t maxXFixed = std::max({ x[0], x[1], x[2] });
+		const int64_t minYFixed = std::min({ y[0], y[1], y[2] });
+		const int64_t maxYFixed = std::max({ y[0], y[1], y[2] });
+
+		triangle.minX = static_cast<int>(std::clamp<int64_t>((minXFixed - halfPixel - sampleReach + SUBPIXEL_SCALE - 1) >> SUBPIXEL_BITS, 0, m_Width));
+		triangle.maxX = static_cast<int>(std::clamp<int64_t>(((maxXFixed - halfPixel + sampleReach) >> SUBPIXEL_BITS) + 1, 0, m_Width));
+		triangle.minY = static_cast<int>(std::clamp<int64_t>((minYFixed - halfPixel - sampleReach + SUBPIXEL_SCALE - 1) >> SUBPIXEL_BITS, 0, m_Height));
+		triangle.maxY = static_cast<int>(std::clamp<int64_t>(((maxYFixed - halfPixel + sampleReach) >> SUBPIXEL_BITS) + 1, 0, m_Height));
+
+		if (triangle.minX >= triangle.maxX || triangle.minY >= triangle.maxY)	// nothing on screen
+			return TriangleCull::Offscreen;
+
+		// EDGE FUNCTIONS, edge i is opposite of vertex i
+		TriangleSetup& setup = triangle.setup;
+		for (int idx{}; idx < 3; ++idx)
+		{
+			const int from = (idx + 1) % 3;
+			const int to = (idx + 2) % 3;
+			const int64_t edgeX = x[to] - x[from];
+			const int64_t edgeY = y[to] - y[from];
+
+			setup.edgeA[idx] = -edgeY;
+			setup.edgeB[idx] = edgeX;
+			setup.edgeC[idx] = edgeY * x[from] - edgeX * y[from];
+
+			// Top-left fill rule: pixel centers exactly on an edge only belong to top and left edges
+			const bool isTopLeft = edgeY < 0 || (edgeY == 0 && edgeX > 0);
+			if (!isTopLeft)
+				setup.edgeC[idx] -= 1;
+		}
+
+		// ATTRIBUTE PLANES (from the barycentric gradients)
+		const float invArea = 1.f / (static_cast<float>(area) / (SUBPIXEL_SCALE * SUBPIXEL_SCALE));
+		float weightDx[3], weightDy[3];
+		for (int idx{}; idx < 3; ++idx)
+		{
+			weightDx[idx] = static_cast<float>(setup.edgeA[idx]) / SUBPIXEL_SCALE * invArea;
+			weightDy[idx] = static_cast<float>(setup.edgeB[idx]) / SUBPIXEL_SCALE * invArea;
+		}
+		setup.originX = static_cast<float>(x[0]) / SUBPIXEL_SCALE;
+		setup.originY = static_cast<float>(y[0]) / SUBPIXEL_SCALE;
+
+		auto makePlane = [&](const float values[3])
+			{
+				AttributePlane plane{};
+				plane.origin = values[0];
+				plane.dx = values[0] * weightDx[0] + values[1] * weightDx[1] + values[2] * weightDx[2];
+				plane.dy = values[0] * weightDy[0] + values[1] * weightDy[1] + values[2] * weightDy[2];
+				return plane;
+			};
+		auto makeStreamPlane = [&](const FloatStream& stream, const float invW[3])
 			{
-				if (v0Weight > 0) return false;
-				if (v1Weight > 0) return false;
-				if (v2Weight > 0) return false;
+				const float values[3]{ stream[indices[0]] * invW[0], stream[indices[1]] * invW[1], stream[indices[2]] * invW[2] };
+				return makePlane(values);
+			};
+
+		const float invDepth[3]{ 1.f / vertices.position.z[indices[0]], 1.f / vertices.position.z[indices[1]], 1.f / vertices.position.z[indices[2]] };
+		setup.invDepth = makePlane(invDepth);
+		if constexpr (Pipeline::isDepthOnly)
+			return TriangleCull::Visible;
+
+		const float invW[3]{ 1.f / vertices.position.w[indices[0]], 1.f / vertices.position.w[indices[1]], 1.f / vertices.position.w[indices[2]] };
+		setup.invW = makePlane(invW);
+		triangle.depth = (vertices.position.w[indices[0]] + vertices.position.w[indices[1]] + vertices.position.w[indices[2]]) / 3.f;
+
+		if constexpr (Pipeline::hasUV)
+		{
+			setup.uv[0] = makeStreamPlane(vertices.uv.x, invW);
+			setup.uv[1] = makeStreamPlane(vertices.uv.y, invW);
+		}
+		if constexpr (Pipeline::hasNormal)
+		{
+			setup.normal[0] = makeStreamPlane(vertices.normal.x, invW);
+			setup.normal[1] = makeStreamPlane(vertices.normal.y, invW);
+			setup.normal[2] = makeStreamPlane(vertices.normal.z, invW);
+		}
+		if constexpr (Pipeline::hasTangent)
+		{
+			setup.tangent[0] = makeStreamPlane(vertices.tangent.x, invW);
+			setup.tangent[1] = makeStreamPlane(vertices.tangent.y, invW);
+			setup.tangent[2] = makeStreamPlane(vertices.tangent.z, invW);
+		}
+		if constexpr (Pipeline::hasViewDirection)
+		{
+			setup.viewDirection[0] = makeStreamPlane(vertices.viewDirection.x, invW);
+			setup.viewDirection[1] = makeStreamPlane(vertices.viewDirection.y, invW);
+			setup.viewDirection[2] = makeStreamPlane(vertices.viewDirection.z, invW);
+		}
+		return TriangleCull::Visible;
+	}
+
+	// RASTERIZATION STAGE (one screen tile, triangles in submission order)
+	template<typename Pipeline>
+	void Renderer::RenderTile(Tile& tile)
+	{
+		const auto tileStart = ProfileClock::now();
+		tile.shadingMs = 0.0;
+
+		// clear buffers
+		for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+		{
+			uint32_t* pColors = GetSampleColors(sampleIdx);
+			const size_t planeOffset = sampleIdx * m_SamplePlaneSize;
+			for (int py{ tile.minY }; py < tile.maxY; ++py)
+			{
+				std::fill_n(pColors + tile.minX + py * m_Width, tile.maxX - tile.minX, m_ClearColor);
+				std::fill_n(m_DepthBuffer.begin() + planeOffset + tile.minX + py * m_Width, tile.maxX - tile.minX, FLT_MAX);
+				if (m_IsDeferredShading)
+					std::fill_n(m_VisibilityBuffer.begin() + planeOffset + tile.minX + py * m_Width, tile.maxX - tile.minX, NO_TRIANGLE);
 			}
-			break;
-		case dae::Back:
-			if (v0Weight < 0) return false;
-			if (v1Weight < 0) return false;
-			if (v2Weight < 0) return false;
-			break;
-		case dae::Front:
-			if (v0Weight > 0) return false;
-			if (v1Weight > 0) return false;
-			if (v2Weight > 0) return false;
-			break;
-		default:
-			break;
+		}
+		for (int blockY{ tile.minY / BLOCK_SIZE }; blockY * BLOCK_SIZE < tile.maxY; ++blockY)
+		{
+			for (int blockX{ tile.minX / BLOCK_SIZE }; blockX * BLOCK_SIZE < tile.maxX; ++blockX)
+				m_HiZBuffer[blockX + blockY * m_HiZWidth] = HiZBlock{};
 		}
 
-		// Calculate WEIGHTS
-		float totalArea = Vector2::Cross(Vector2{ v1.x - v0.x, v1.y - v0.y }, Vector2{ v2.x - v0.x, v2.y - v0.y });
+		const FloatV laneX = GetQuadLaneX();
+		const FloatV laneY = GetQuadLaneY();
 
-		v0Weight /= totalArea;
-		v1Weight /= totalArea;
-		v2Weight /= totalArea;
+		QuadVertices quadVertices{};
 
-		// Perspective-correct weights
-		float denomDepth = v0Weight / v0.z + v1Weight / v1.z + v2Weight / v2.z;
-		float denomDepthW = v0Weight / v0.w + v1Weight / v1.w + v2Weight / v2.w;
-		float w0 = (v0Weight / vertex0.position.w) / denomDepthW;
-		float w1 = (v1Weight / vertex1.position.w) / denomDepthW;
-		float w2 = (v2Weight / vertex2.position.w) / denomDepthW;
+		uint64_t pixelCount{};
+		uint64_t shadedPixelCount{};
+		uint64_t testedPixelCount{};
+		uint64_t textureSampleCount{};
 
-		// Interpolate depth
-		float interpolatedDepth = 1.0f / denomDepth;
+		// Depth test (per sample), interpolation and shading (per pixel) of the covered lanes of one quad, returns if any depth got written
+		auto rasterizeQuad = [&](uint32_t triangleIdx, int qx, int qy, const int* pSampleCoverage)
+			{
+				const BinnedTriangle& triangle = m_BinnedTriangles[triangleIdx];
+				const TriangleSetup& setup = triangle.setup;
 
-		// Depth Check
-		if (interpolatedDepth >= 0 and
-			interpolatedDepth <= 1)
+				int sampleVisible[MAX_SAMPLE_COUNT];
+				const int visible = DepthTestQuad<true>(setup, tile, qx, qy, pSampleCoverage, sampleVisible);
+				if (!visible)
+					return false;
+
+				pixelCount += std::popcount(static_cast<uint32_t>(visible));
+				if constexpr (Pipeline::isDepthOnly)	// shaded after all tiles, once the depth range is known
+					return true;
+				else
+				{
+					if (m_IsDeferredShading)	// only remember the triangle, shaded once the tile is done
+					{
+						for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+						{
+							uint32_t* pVisibility = m_VisibilityBuffer.data() + sampleIdx * m_SamplePlaneSize;
+							for (int lanes{ sampleVisible[sampleIdx] }; lanes != 0; lanes &= lanes - 1)
+							{
+								const int lane = std::countr_zero(static_cast<uint32_t>(lanes));
+								pVisibility[qx + lane % QUAD_WIDTH + (qy + lane / QUAD_WIDTH) * m_Width] = triangleIdx;
+							}
+						}
+						return true;
+					}
+
+					const FloatV relativeX = FloatV{ qx + 0.5f - setup.originX } + laneX;	// point in middle of pixel (not top left)
+					const FloatV relativeY = FloatV{ qy + 0.5f - setup.originY } + laneY;
+					textureSampleCount += ShadeQuad<Pipeline>(triangle, qx, qy, visible, sampleVisible, relativeX, relativeY, quadVertices);
+					shadedPixelCount += std::popcount(static_cast<uint32_t>(visible));
+					return true;
+				}
+			};
+
+		for (const uint32_t triangleIdx : tile.triangleIndices)
 		{
-			if (m_DepthBuffer[(int)pixel.x + (int)pixel.y * m_Width] >= interpolatedDepth)
+			if (m_ShowAABBVisualization)
 			{
-				m_DepthBuffer[(int)pixel.x + (int)pixel.y * m_Width] = interpolatedDepth;
+				// Bounding box clipped to the tile
+				const BinnedTriangle& triangle = m_BinnedTriangles[triangleIdx];
+				const int minX = std::max(triangle.minX, tile.minX);
+				const int maxX = std::min(triangle.maxX, tile.maxX);
+				const int minY = std::max(triangle.minY, tile.minY);
+				const int maxY = std::min(triangle.maxY, tile.maxY);
+
+				for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+				{
+					for (int py{ minY }; py < maxY; ++py)
+					{
+						//Update Color in Buffer
+						std::fill_n(GetSampleColors(sampleIdx) + minX + py * m_Width, maxX - minX, m_BackBufferLayout.Pack(
+							static_cast<uint8_t>(255),
+							static_cast<uint8_t>(255),
+							static_cast<uint8_t>(255)));
+					}
+				}
+				continue;
 			}
-			else return false; // if not in front, dont render
+
+			testedPixelCount += RasterizeTriangle(triangleIdx, tile, rasterizeQuad);
 		}
-		else return false; // if not in 0,1 range, dont render
 
+		tile.pixelCount = pixelCount;
+		tile.shadedPixelCount = shadedPixelCount;
+		tile.testedPixelCount = testedPixelCount;
+		tile.textureSampleCount = textureSampleCount;
 
-		// Interpolate vertices 
-		interpolatedVertex.normal = (vertex0.normal * w0 + vertex1.normal * w1 + vertex2.normal * w2).Normalized();
-		interpolatedVertex.uv = vertex0.uv * w0 + vertex1.uv * w1 + vertex2.uv * w2; // Interpolate UV using perspective-correct weights
-		//interpolatedVertex.color = vertex0.color * w0 + vertex1.color * w1 + vertex2.color * w2;
-		if (m_CurrentShadingMode == ShadingMode::Combined || m_CurrentShadingMode == ShadingMode::Specular)
-			interpolatedVertex.viewDirection = (vertex0.viewDirection * w0 + vertex1.viewDirection * w1 + vertex2.viewDirection * w2).Normalized();
-		//interpolatedVertex.position = Vector4{w0,w1,w2, interpolatedDepth };	//for debug
+		// DEFERRED SHADING (the visibility of the tile is final now)
+		if constexpr (!Pipeline::isDepthOnly)
+		{
+			ProfileScope shadingScope{ m_Profiler, tile.shadingMs, "shading", &tile - m_Tiles.data() };
+			if (m_IsDeferredShading)
+				ShadeVisibleTile<Pipeline>(tile);
 
+			// MSAA RESOLVE (the transparent pass blends per pixel)
+			ResolveTile(tile);
 
+			// TRANSPARENT PASS (on top of the finished opaque color + depth of the tile)
+			BlendTransparentTile(tile);
+		}
 
-		if (m_IsNormalMapVisible)
+		// Depth range of the tile for the depth visualization
+		tile.minDepth = FLT_MAX;
+		tile.maxDepth = 0.f;
+		for (int blockY{ tile.minY / BLOCK_SIZE }; blockY * BLOCK_SIZE < tile.maxY; ++blockY)
 		{
-			interpolatedVertex.tangent = (vertex0.tangent * w0 + vertex1.tangent * w1 + vertex2.tangent * w2).Normalized();
+			for (int blockX{ tile.minX / BLOCK_SIZE }; blockX * BLOCK_SIZE < tile.maxX; ++blockX)
+			{
+				const HiZBlock& hiZBlock = m_HiZBuffer[blockX + blockY * m_HiZWidth];
+				tile.minDepth = std::min(tile.minDepth, hiZBlock.minDepth);
+				tile.maxDepth = std::max(tile.maxDepth, hiZBlock.maxVisibleDepth);
+			}
+		}
 
-			Vector3 binormal = dae::Vector3::Cross(interpolatedVertex.normal, interpolatedVertex.tangent).Normalized();
+		tile.rasterizationMs = std::chrono::duration<double, std::milli>(ProfileClock::now() - tileStart).count() - tile.shadingMs;
+	}
 
-			dae::Matrix tangentSpaceAxis = { interpolatedVertex.tangent, binormal, interpolatedVertex.normal, Vector3::Zero };
+	// Coverage + Hi-Z traversal of one triangle within a tile: blocks first, then the quads of every block that isn't rejected.
+	// rasterizeQuad(triangleIdx, qx, qy, pSampleCoverage) gets the covered lanes of every sample and returns if it wrote depth,
+	// which refreshes the Hi-Z block. Returns the covered pixels (handed to the depth test)
+	template<typename QuadFunction>
+	uint64_t Renderer::RasterizeTriangle(uint32_t triangleIdx, const Tile& tile, const QuadFunction& rasterizeQuad)
+	{
+		const BinnedTriangle& triangle = m_BinnedTriangles[triangleIdx];
+		const TriangleSetup& setup = triangle.setup;
+
+		// Bounding box clipped to the tile
+		const int minX = std::max(triangle.minX, tile.minX);
+		const int maxX = std::min(triangle.maxX, tile.maxX);
+		const int minY = std::max(triangle.minY, tile.minY);
+		const int maxY = std::min(triangle.maxY, tile.maxY);
+
+		// Edge function steps per quad, plus the offset of every lane (and sample) within a quad
+		const SamplePosition* pSamplePattern = GetSamplePattern(m_SampleCount);
+		constexpr int64_t sampleScale{ SUBPIXEL_SCALE / SAMPLE_POSITION_SCALE };
+		int64_t stepX[3], stepY[3], laneEdge[3][MAX_SAMPLE_COUNT][SIMD_WIDTH];
+		int64_t sampleMargin[3];	// how far an edge function can change from the pixel center to a sample
+		for (int idx{}; idx < 3; ++idx)
+		{
+			stepX[idx] = setup.edgeA[idx] * SUBPIXEL_SCALE * QUAD_WIDTH;
+			stepY[idx] = setup.edgeB[idx] * SUBPIXEL_SCALE * QUAD_HEIGHT;
+			for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+			{
+				const int64_t sampleEdge = (setup.edgeA[idx] * pSamplePattern[sampleIdx].x + setup.edgeB[idx] * pSamplePattern[sampleIdx].y) * sampleScale;
+				for (int lane{}; lane < SIMD_WIDTH; ++lane)
+					laneEdge[idx][sampleIdx][lane] = (setup.edgeA[idx] * (lane % QUAD_WIDTH) + setup.edgeB[idx] * (lane / QUAD_WIDTH)) * SUBPIXEL_SCALE + sampleEdge;
+			}
+			sampleMargin[idx] = m_SampleCount > 1 ? (std::abs(setup.edgeA[idx]) + std::abs(setup.edgeB[idx])) * SUBPIXEL_SCALE / 2 : 0;
+		}
+		const float sampleReach = m_SampleCount > 1 ? 0.5f : 0.f;	// in pixels
 
-			Vector3 sampledNormal = { pNormaltexture->Sample(interpolatedVertex.uv).r, pNormaltexture->Sample(interpolatedVertex.uv).g, pNormaltexture->Sample(interpolatedVertex.uv).b };
+		// Blocks (and the quads in them) are aligned to the tile, lanes outside the bounding box are never covered
+		const int blockMinX = minX / BLOCK_SIZE * BLOCK_SIZE;
+		const int blockMinY = minY / BLOCK_SIZE * BLOCK_SIZE;
 
-			//	sampledNormal /= 255;		//-> not necessary, texture sample output is already 0-1
-			sampledNormal = 2.f * sampledNormal - Vector3{ 1.f, 1.f, 1.f };
-			sampledNormal = tangentSpaceAxis.TransformVector(sampledNormal).Normalized();
+		uint64_t coveredPixelCount{};
+		int sampleCoverage[MAX_SAMPLE_COUNT];
+		for (int by{ blockMinY }; by < maxY; by += BLOCK_SIZE)
+		{
+			for (int bx{ blockMinX }; bx < maxX; bx += BLOCK_SIZE)
+			{
+				// Classify the block with the edge functions at its corner pixels (widened to reach their samples):
+				// outside of one edge -> skip, inside of all edges -> no per pixel coverage test
+				const int64_t blockX = static_cast<int64_t>(bx) * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2;
+				const int64_t blockY = static_cast<int64_t>(by) * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2;
+				int64_t blockEdge[3];
+				bool isOutside{ false };
+				bool isInside{ bx >= minX && by >= minY && bx + BLOCK_SIZE <= maxX && by + BLOCK_SIZE <= maxY };
+				for (int idx{}; idx < 3; ++idx)
+				{
+					blockEdge[idx] = setup.edgeA[idx] * blockX + setup.edgeB[idx] * blockY + setup.edgeC[idx];
+
+					const int64_t spanX = setup.edgeA[idx] * (BLOCK_SIZE - 1) * SUBPIXEL_SCALE;
+					const int64_t spanY = setup.edgeB[idx] * (BLOCK_SIZE - 1) * SUBPIXEL_SCALE;
+					if (blockEdge[idx] + std::max<int64_t>(spanX, 0) + std::max<int64_t>(spanY, 0) + sampleMargin[idx] < 0)
+						isOutside = true;
+					if (blockEdge[idx] + std::min<int64_t>(spanX, 0) + std::min<int64_t>(spanY, 0) - sampleMargin[idx] < 0)
+						isInside = false;
+				}
+				if (isOutside)
+					continue;
+
+				// Hi-Z: 1/z is linear in screen space, so its largest value on the block is at one of the corners.
+				// A pixel only passes the depth test when 1/z >= 1 (depth <= 1) and 1/z >= 1 / buffer depth
+				HiZBlock& hiZBlock = m_HiZBuffer[bx / BLOCK_SIZE + (by / BLOCK_SIZE) * m_HiZWidth];
+				const float relativeX = bx + 0.5f - sampleReach - setup.originX;
+				const float relativeY = by + 0.5f - sampleReach - setup.originY;
+				const float maxInvDepth = setup.invDepth.Evaluate(relativeX, relativeY)
+					+ std::max(setup.invDepth.dx * (BLOCK_SIZE - 1 + 2.f * sampleReach), 0.f) + std::max(setup.invDepth.dy * (BLOCK_SIZE - 1 + 2.f * sampleReach), 0.f);
+				if (maxInvDepth * HIZ_TOLERANCE < std::max(1.f, 1.f / hiZBlock.maxDepth))	// completely hidden
+					continue;
+
+				// RENDERING (quads of the block)
+				bool isDepthWritten{ false };
+				const int blockMaxX = std::min(bx + BLOCK_SIZE, maxX);
+				const int blockMaxY = std::min(by + BLOCK_SIZE, maxY);
+				for (int qy{ by }; qy < blockMaxY; qy += QUAD_HEIGHT)
+				{
+					int64_t edge0 = blockEdge[0], edge1 = blockEdge[1], edge2 = blockEdge[2];
+					blockEdge[0] += stepY[0];
+					blockEdge[1] += stepY[1];
+					blockEdge[2] += stepY[2];
 
-			interpolatedVertex.normal = sampledNormal;
+					for (int qx{ bx }; qx < blockMaxX; qx += QUAD_WIDTH, edge0 += stepX[0], edge1 += stepX[1], edge2 += stepX[2])
+					{
+						if (isInside)
+						{
+							std::fill_n(sampleCoverage, m_SampleCount, FULL_QUAD_MASK);
+							coveredPixelCount += SIMD_WIDTH;
+							isDepthWritten |= rasterizeQuad(triangleIdx, qx, qy, sampleCoverage);
+							continue;
+						}
+
+						// Lanes of the quad inside the bounding box
+						int inBounds{ FULL_QUAD_MASK };
+						if (qx + QUAD_WIDTH > maxX || qy + QUAD_HEIGHT > maxY)
+						{
+							inBounds = 0;
+							for (int lane{}; lane < SIMD_WIDTH; ++lane)
+								inBounds |= static_cast<int>(qx + lane % QUAD_WIDTH < maxX && qy + lane / QUAD_WIDTH < maxY) << lane;
+						}
+
+						// Coverage, exact in fixed point -> one bit per lane and sample
+						int coverage{};
+						for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+						{
+							int lanes{};
+							for (int lane{}; lane < SIMD_WIDTH; ++lane)
+							{
+								const int64_t edges = (edge0 + laneEdge[0][sampleIdx][lane]) | (edge1 + laneEdge[1][sampleIdx][lane]) | (edge2 + laneEdge[2][sampleIdx][lane]);
+								lanes |= static_cast<int>(edges >= 0) << lane;
+							}
+							sampleCoverage[sampleIdx] = lanes & inBounds;
+							coverage |= sampleCoverage[sampleIdx];
+						}
+						if (coverage)
+						{
+							coveredPixelCount += std::popcount(static_cast<uint32_t>(coverage));
+							isDepthWritten |= rasterizeQuad(triangleIdx, qx, qy, sampleCoverage);
+						}
+					}
+				}
+
+				if (isDepthWritten)
+					UpdateHiZBlock(bx / BLOCK_SIZE, by / BLOCK_SIZE, tile);
+			}
+		}
+		return coveredPixelCount;
+	}
+
+	// Depth test of the covered lanes of a quad, one test per sample (optionally writing the depth of the passing ones).
+	// pSampleVisible receives the passing lanes of every sample, returns the lanes where any sample passed
+	template<bool IsDepthWritten>
+	int Renderer::DepthTestQuad(const TriangleSetup& setup, const Tile& tile, int qx, int qy, const int* pSampleCoverage, int* pSampleVisible)
+	{
+		const FloatV laneX = GetQuadLaneX();
+		const FloatV laneY = GetQuadLaneY();
+		const FloatV zero{ 0.f }, one{ 1.f };
+
+		const int columnCount = std::min(QUAD_WIDTH, tile.maxX - qx);
+		const int rowCount = std::min(QUAD_HEIGHT, tile.maxY - qy);
+
+		int visible{};
+		for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+		{
+			pSampleVisible[sampleIdx] = 0;
+			if (!pSampleCoverage[sampleIdx])
+				continue;
+
+			// Depth Check on all lanes
+			float* pDepth = m_DepthBuffer.data() + sampleIdx * m_SamplePlaneSize;
+			alignas(32) float quadDepth[SIMD_WIDTH]{};
+			for (int row{}; row < rowCount; ++row)
+				std::copy_n(pDepth + qx + (qy + row) * m_Width, columnCount, quadDepth + row * QUAD_WIDTH);
+
+			const FloatV sampleX = FloatV{ qx + 0.5f + m_SampleOffsetX[sampleIdx] - setup.originX } + laneX;	// pixel center without multisampling
+			const FloatV sampleY = FloatV{ qy + 0.5f + m_SampleOffsetY[sampleIdx] - setup.originY } + laneY;
+			const FloatV interpolatedDepth = one / setup.invDepth.Evaluate(sampleX, sampleY);
+			const FloatV bufferDepth = FloatV::Load(quadDepth);
+			const FloatV isDepthPassed = (interpolatedDepth >= zero) & (interpolatedDepth <= one) & (interpolatedDepth <= bufferDepth);	// in 0,1 range and in front
+
+			const int sampleVisible = pSampleCoverage[sampleIdx] & FloatV::MoveMask(isDepthPassed);
+			if (!sampleVisible)
+				continue;
+
+			// Masked depth write
+			if constexpr (IsDepthWritten)
+			{
+				FloatV::Select(FloatV::LaneMask(sampleVisible), interpolatedDepth, bufferDepth).Store(quadDepth);
+				for (int row{}; row < rowCount; ++row)
+					std::copy_n(quadDepth + row * QUAD_WIDTH, columnCount, pDepth + qx + (qy + row) * m_Width);
+			}
+
+			pSampleVisible[sampleIdx] = sampleVisible;
+			visible |= sampleVisible;
+		}
+		return visible;
+	}
+
+	// MSAA RESOLVE: average of the sample colors of every pixel of the tile into the back buffer
+	void Renderer::ResolveTile(const Tile& tile)
+	{
+		if (m_SampleCount == 1)	// rendered straight into the back buffer
+			return;
+
+		for (int py{ tile.minY }; py < tile.maxY; ++py)
+		{
+			for (int px{ tile.minX }; px < tile.maxX; ++px)
+			{
+				const size_t pixelIdx = px + (py * static_cast<size_t>(m_Width));
+				const uint32_t firstColor = m_SampleColorBuffer[pixelIdx];
+
+				// Inside a triangle all samples got the same color
+				bool isUniform{ true };
+				for (int sampleIdx{ 1 }; sampleIdx < m_SampleCount; ++sampleIdx)
+					isUniform &= m_SampleColorBuffer[pixelIdx + sampleIdx * m_SamplePlaneSize] == firstColor;
+				if (isUniform)
+				{
+					m_pBackBufferPixels[pixelIdx] = firstColor;
+					continue;
+				}
+
+				uint32_t sum[3]{};
+				for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+				{
+					const uint32_t sample = m_SampleColorBuffer[pixelIdx + sampleIdx * m_SamplePlaneSize];
+					sum[0] += m_BackBufferLayout.GetRed(sample);
+					sum[1] += m_BackBufferLayout.GetGreen(sample);
+					sum[2] += m_BackBufferLayout.GetBlue(sample);
+				}
+				const uint32_t rounding = m_SampleCount / 2;
+				m_pBackBufferPixels[pixelIdx] = m_BackBufferLayout.Pack(
+					static_cast<uint8_t>((sum[0] + rounding) / m_SampleCount),
+					static_cast<uint8_t>((sum[1] + rounding) / m_SampleCount),
+					static_cast<uint8_t>((sum[2] + rounding) / m_SampleCount));
+			}
+		}
+	}
+
+	// Hi-Z: refresh the coarse depth of a block after triangles drew into it
+	void Renderer::UpdateHiZBlock(int blockX, int blockY, const Tile& tile)
+	{
+		HiZBlock hiZBlock{ FLT_MAX, 0.f, 0.f };
+
+		const int maxX = std::min((blockX + 1) * BLOCK_SIZE, tile.maxX);
+		const int maxY = std::min((blockY + 1) * BLOCK_SIZE, tile.maxY);
+		for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+		{
+			const float* pDepth = m_DepthBuffer.data() + sampleIdx * m_SamplePlaneSize;
+			for (int py{ blockY * BLOCK_SIZE }; py < maxY; ++py)
+			{
+				for (int px{ blockX * BLOCK_SIZE }; px < maxX; ++px)
+				{
+					const float depth = pDepth[px + (py * m_Width)];
+					hiZBlock.minDepth = std::min(hiZBlock.minDepth, depth);
+					hiZBlock.maxDepth = std::max(hiZBlock.maxDepth, depth);
+					if (depth != FLT_MAX)
+						hiZBlock.maxVisibleDepth = std::max(hiZBlock.maxVisibleDepth, depth);
+				}
+			}
+		}
+
+		m_HiZBuffer[blockX + blockY * m_HiZWidth] = hiZBlock;
+	}
+
+	// Depth visualization of a tile, remapped to the depth range of the frame (per sample, then resolved)
+	void Renderer::ShadeDepthTile(Tile& tile, float minDepth, float maxDepth)
+	{
+		ProfileScope shadingScope{ m_Profiler, tile.shadingMs, "depthShading", &tile - m_Tiles.data() };
 
+		for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+		{
+			const float* pDepth = m_DepthBuffer.data() + sampleIdx * m_SamplePlaneSize;
+			uint32_t* pColors = GetSampleColors(sampleIdx);
+			for (int py{ tile.minY }; py < tile.maxY; ++py)
+			{
+				for (int px{ tile.minX }; px < tile.maxX; ++px)
+				{
+					const float depth = pDepth[px + (py * m_Width)];
+					if (depth == FLT_MAX)	// nothing drawn
+						continue;
+
+					ColorRGB finalColor = colors::White * Remap(depth, minDepth, maxDepth);
+					finalColor.MaxToOne();
+					//Update Color in Buffer
+					pColors[px + (py * m_Width)] = m_BackBufferLayout.Pack(
+						static_cast<uint8_t>(finalColor.r * 255),
+						static_cast<uint8_t>(finalColor.g * 255),
+						static_cast<uint8_t>(finalColor.b * 255));
+				}
+			}
 		}
 
-		return true;
+		ResolveTile(tile);
 	}
 
-	// Shading
+	// DEFERRED SHADING STAGE (every visible pixel of the tile once, quads grouped per triangle)
+	template<typename Pipeline>
+	void Renderer::ShadeVisibleTile(Tile& tile)
+	{
+		const FloatV laneX = GetQuadLaneX();
+		const FloatV laneY = GetQuadLaneY();
+
+		QuadVertices quadVertices{};
+
+		uint64_t shadedPixelCount{};
+		uint64_t textureSampleCount{};
+		for (int qy{ tile.minY }; qy < tile.maxY; qy += QUAD_HEIGHT)
+		{
+			for (int qx{ tile.minX }; qx < tile.maxX; qx += QUAD_WIDTH)
+			{
+				uint32_t triangleIndices[MAX_SAMPLE_COUNT][SIMD_WIDTH];
+				int remaining[MAX_SAMPLE_COUNT]{};
+				int remainingLanes{};
+				for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+				{
+					const uint32_t* pVisibility = m_VisibilityBuffer.data() + sampleIdx * m_SamplePlaneSize;
+					for (int lane{}; lane < SIMD_WIDTH; ++lane)
+					{
+						const int px = qx + lane % QUAD_WIDTH;
+						const int py = qy + lane / QUAD_WIDTH;
+						triangleIndices[sampleIdx][lane] = px < tile.maxX && py < tile.maxY ? pVisibility[px + (py * m_Width)] : NO_TRIANGLE;
+						if (triangleIndices[sampleIdx][lane] != NO_TRIANGLE)
+							remaining[sampleIdx] |= 1 << lane;
+					}
+					remainingLanes |= remaining[sampleIdx];
+				}
+
+				// One interpolation per triangle that is visible in the quad, shared by all of its samples
+				while (remainingLanes)
+				{
+					int firstSample{};
+					while (!remaining[firstSample])
+						++firstSample;
+					const uint32_t triangleIdx = triangleIndices[firstSample][std::countr_zero(static_cast<uint32_t>(remaining[firstSample]))];
+
+					int sampleLanes[MAX_SAMPLE_COUNT]{};
+					int lanes{};
+					remainingLanes = 0;
+					for (int sampleIdx{ firstSample }; sampleIdx < m_SampleCount; ++sampleIdx)
+					{
+						for (int lane{}; lane < SIMD_WIDTH; ++lane)
+						{
+							if (triangleIndices[sampleIdx][lane] == triangleIdx)
+								sampleLanes[sampleIdx] |= 1 << lane;
+						}
+						remaining[sampleIdx] &= ~sampleLanes[sampleIdx];
+						remainingLanes |= remaining[sampleIdx];
+						lanes |= sampleLanes[sampleIdx];
+					}
+
+					const BinnedTriangle& triangle = m_BinnedTriangles[triangleIdx];
+					const FloatV relativeX = FloatV{ qx + 0.5f - triangle.setup.originX } + laneX;	// point in middle of pixel (not top left)
+					const FloatV relativeY = FloatV{ qy + 0.5f - triangle.setup.originY } + laneY;
+					textureSampleCount += ShadeQuad<Pipeline>(triangle, qx, qy, lanes, sampleLanes, relativeX, relativeY, quadVertices);
+					shadedPixelCount += std::popcount(static_cast<uint32_t>(lanes));
+				}
+			}
+		}
+		tile.shadedPixelCount += shadedPixelCount;
+		tile.textureSampleCount += textureSampleCount;
+	}
+
+	// TRANSPARENT PASS (partial coverage triangles of one tile, src-alpha blended over the opaque result like the hardware blend state,
+	// or accumulated order independently and resolved once). Depth tested against the opaque depth but never written,
+	// so the depth and Hi-Z of the tile stay those of the opaque geometry
+	void Renderer::BlendTransparentTile(Tile& tile)
+	{
+		tile.blendedPixelCount = 0;
+		if (tile.transparentTriangleIndices.empty() || m_ShowAABBVisualization)
+			return;
+
+		const bool isWeightedBlended = m_TransparencyMode == TransparencyMode::WeightedBlended;
+		if (isWeightedBlended)
+		{
+			for (int py{ tile.minY }; py < tile.maxY; ++py)
+				std::fill_n(m_OITBuffer.begin() + tile.minX + py * m_Width, tile.maxX - tile.minX, OITAccumulation{});
+		}
+		else if (m_TransparencyMode == TransparencyMode::Sorted)
+		{
+			// Back to front within the tile (only the triangles overlapping it), equal depths keep the submission order
+			std::stable_sort(tile.transparentTriangleIndices.begin(), tile.transparentTriangleIndices.end(), [this](uint32_t a, uint32_t b)
+				{
+					return m_BinnedTriangles[a].depth > m_BinnedTriangles[b].depth;
+				});
+		}
+
+		const FloatV laneX = GetQuadLaneX();
+		const FloatV laneY = GetQuadLaneY();
+		const FloatV one{ 1.f };
+
+		QuadVertices quadVertices{};
+
+		uint64_t blendedPixelCount{};
+		uint64_t testedPixelCount{};
+		uint64_t textureSampleCount{};
+
+		// Depth test, texture fetch and blend (or accumulation) of the covered lanes of one quad, never writes depth
+		auto blendQuad = [&](uint32_t triangleIdx, int qx, int qy, const int* pSampleCoverage)
+			{
+				const BinnedTriangle& triangle = m_BinnedTriangles[triangleIdx];
+				const TriangleSetup& setup = triangle.setup;
+
+				int sampleVisible[MAX_SAMPLE_COUNT];
+				const int visible = DepthTestQuad<false>(setup, tile, qx, qy, pSampleCoverage, sampleVisible);
+				if (!visible)
+					return false;
+
+				const FloatV relativeX = FloatV{ qx + 0.5f - setup.originX } + laneX;
+				const FloatV relativeY = FloatV{ qy + 0.5f - setup.originY } + laneY;
+				InterpolateQuad<PartialCoveragePipeline>(setup, relativeX, relativeY, quadVertices);
+				for (int inactiveLanes = ~visible & FULL_QUAD_MASK; inactiveLanes != 0; inactiveLanes &= inactiveLanes - 1)
+				{
+					const int lane = std::countr_zero(static_cast<uint32_t>(inactiveLanes));
+					quadVertices.uv[0][lane] = 0.f;
+					quadVertices.uv[1][lane] = 0.f;
+					quadVertices.uvGradient[lane] = {};
+				}
+
+				ColorAlphaSample samples[SIMD_WIDTH];
+				SampleQuadColorAlpha(m_pMeshesVector[triangle.meshIdx]->GetDiffuseTexture(), quadVertices, m_FilteringMethod, samples);
+				textureSampleCount += std::popcount(static_cast<uint32_t>(visible));
+
+				alignas(32) float viewDepth[SIMD_WIDTH];
+				if (isWeightedBlended)
+					(one / setup.invW.Evaluate(relativeX, relativeY)).Store(viewDepth);
+
+				for (int lanes{ visible }; lanes != 0; lanes &= lanes - 1)
+				{
+					const int lane = std::countr_zero(static_cast<uint32_t>(lanes));
+					const ColorAlphaSample& sample = samples[lane];
+					if (sample.alpha <= 0.f)	// most of a fire card: nothing to blend or accumulate
+						continue;
+
+					const int pixelIdx = qx + lane % QUAD_WIDTH + (qy + lane / QUAD_WIDTH) * m_Width;
+					++blendedPixelCount;
+
+					// Blended once per pixel (after the resolve), weighted by the fraction of its samples the triangle covers
+					float alpha = std::min(sample.alpha, 1.f);
+					if (m_SampleCount > 1)
+					{
+						int sampleCount{};
+						for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+							sampleCount += (sampleVisible[sampleIdx] >> lane) & 1;
+						alpha *= static_cast<float>(sampleCount) / m_SampleCount;
+					}
+
+					if (isWeightedBlended)
+					{
+						// Depth weight of McGuire and Bavoil (eq. 10): closer fragments dominate the average color
+						const float farDepth = Square(viewDepth[lane] / 200.f);
+						const float weight = alpha * std::clamp(10.f / (1e-5f + Square(viewDepth[lane] / 5.f) + farDepth * farDepth * farDepth), 1e-2f, 3e3f);
+
+						OITAccumulation& accumulation = m_OITBuffer[pixelIdx];
+						accumulation.color += sample.color * weight;
+						accumulation.alpha += weight;
+						accumulation.revealage *= 1.f - alpha;
+						continue;
+					}
+
+					// src * alpha + dst * (1 - alpha)
+					uint32_t& pixel = m_pBackBufferPixels[pixelIdx];
+					ColorRGB finalColor = sample.color * alpha + m_BackBufferLayout.Unpack(pixel) * (1.f - alpha);
+
+					finalColor.MaxToOne();
+					pixel = m_BackBufferLayout.Pack(
+						static_cast<uint8_t>(finalColor.r * 255 + .5f),
+						static_cast<uint8_t>(finalColor.g * 255 + .5f),
+						static_cast<uint8_t>(finalColor.b * 255 + .5f));
+				}
+				return false;
+			};
+
+		for (const uint32_t triangleIdx : tile.transparentTriangleIndices)
+			testedPixelCount += RasterizeTriangle(triangleIdx, tile, blendQuad);
+
+		tile.blendedPixelCount = blendedPixelCount;
+		tile.testedPixelCount += testedPixelCount;
+		tile.textureSampleCount += textureSampleCount;
+
+		if (isWeightedBlended)
+			ResolveTransparentTile(tile);
+	}
+
+	// Weighted blended OIT resolve: average transparent color over the opaque color, once per pixel
+	void Renderer::ResolveTransparentTile(const Tile& tile)
+	{
+		for (int py{ tile.minY }; py < tile.maxY; ++py)
+		{
+			for (int px{ tile.minX }; px < tile.maxX; ++px)
+			{
+				const OITAccumulation& accumulation = m_OITBuffer[px + (py * m_Width)];
+				if (accumulation.alpha <= 0.f)	// no transparent fragment
+					continue;
+
+				uint32_t& pixel = m_pBackBufferPixels[px + (py * m_Width)];
+				const ColorRGB averageColor = accumulation.color / accumulation.alpha;
+				ColorRGB finalColor = averageColor * (1.f - accumulation.revealage) + m_BackBufferLayout.Unpack(pixel) * accumulation.revealage;
+
+				finalColor.MaxToOne();
+				pixel = m_BackBufferLayout.Pack(
+					static_cast<uint8_t>(finalColor.r * 255 + .5f),
+					static_cast<uint8_t>(finalColor.g * 255 + .5f),
+					static_cast<uint8_t>(finalColor.b * 255 + .5f));
+			}
+		}
+	}
+
+	// Normal mapping + shading of the given lanes of a quad (x, y relative to the setup origin), once per pixel:
+	// the color goes to every sample of pSampleLanes. Returns the texture samples it took
+	template<typename Pipeline>
+	int Renderer::ShadeQuad(const BinnedTriangle& triangle, int qx, int qy, int lanes, const int* pSampleLanes, const FloatV& x, const FloatV& y, QuadVertices& quadVertices)
+	{
+		const Mesh* pMesh = m_pMeshesVector[triangle.meshIdx];
+
+		InterpolateQuad<Pipeline>(triangle.setup, x, y, quadVertices);
+
+		// Texture fetches for the whole quad, only the maps the pipeline reads
+		ColorRGB normalSamples[SIMD_WIDTH];
+		ColorRGB diffuseSamples[SIMD_WIDTH]{};
+		float specularSamples[SIMD_WIDTH]{};
+		float glossinessSamples[SIMD_WIDTH]{};
+		int textureSampleCount{};
+		if constexpr (Pipeline::hasUV)
+		{
+			const int laneCount = std::popcount(static_cast<uint32_t>(lanes));
+
+			// Lanes outside the triangle carry extrapolated UVs, keep them in range for the batched fetches
+			for (int inactiveLanes = ~lanes & FULL_QUAD_MASK; inactiveLanes != 0; inactiveLanes &= inactiveLanes - 1)
+			{
+				const int lane = std::countr_zero(static_cast<uint32_t>(inactiveLanes));
+				quadVertices.uv[0][lane] = 0.f;
+				quadVertices.uv[1][lane] = 0.f;
+				quadVertices.uvGradient[lane] = {};
+			}
+
+			if (const Texture* pMaterialTexture = pMesh->GetMaterialTexture())
+			{
+				// Packed material: one fetch per lane for all maps
+				MaterialSample materialSamples[SIMD_WIDTH];
+				SampleQuadMaterial(pMaterialTexture, quadVertices, m_FilteringMethod, materialSamples);
+				textureSampleCount = laneCount;
+				for (int lane{}; lane < SIMD_WIDTH; ++lane)
+				{
+					normalSamples[lane] = materialSamples[lane].normal;
+					diffuseSamples[lane] = materialSamples[lane].diffuse;
+					specularSamples[lane] = materialSamples[lane].specular;
+					glossinessSamples[lane] = materialSamples[lane].glossiness;
+				}
+			}
+			else
+			{
+				if constexpr (Pipeline::hasNormalMap)
+					SampleQuad(pMesh->GetNormalTexture(), quadVertices, m_FilteringMethod, normalSamples);
+				if constexpr (Pipeline::isDiffuseSampled)
+					SampleQuad(pMesh->GetDiffuseTexture(), quadVertices, m_FilteringMethod, diffuseSamples);
+				if constexpr (Pipeline::isSpecularSampled)
+				{
+					SampleQuadRed(pMesh->GetSpecularTexture(), quadVertices, m_FilteringMethod, specularSamples);
+					SampleQuadRed(pMesh->GetGlossinessTexture(), quadVertices, m_FilteringMethod, glossinessSamples);
+				}
+				textureSampleCount = laneCount * (static_cast<int>(Pipeline::hasNormalMap) + static_cast<int>(Pipeline::isDiffuseSampled) + 2 * static_cast<int>(Pipeline::isSpecularSampled));
+			}
+		}
+
+		for (; lanes != 0; lanes &= lanes - 1)
+		{
+			const int lane = std::countr_zero(static_cast<uint32_t>(lanes));
+			const int px = qx + lane % QUAD_WIDTH;
+			const int py = qy + lane / QUAD_WIDTH;
+
+			Vertex_Out interpolatedVertex = quadVertices.GetVertex(lane);
+			if constexpr (Pipeline::hasNormalMap)
+				ApplyNormalMap(interpolatedVertex, normalSamples[lane]);
+
+			// Shade
+			ColorRGB finalColor = PixelShading<Pipeline>(interpolatedVertex,
+				diffuseSamples[lane], specularSamples[lane], glossinessSamples[lane]);
+
+			finalColor.MaxToOne();
+			//Update Color in Buffer
+			const uint32_t color = m_BackBufferLayout.Pack(
+				static_cast<uint8_t>(finalColor.r * 255),
+				static_cast<uint8_t>(finalColor.g * 255),
+				static_cast<uint8_t>(finalColor.b * 255));
+			for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+			{
+				if ((pSampleLanes[sampleIdx] >> lane) & 1)
+					GetSampleColors(sampleIdx)[px + (py * m_Width)] = color;
+			}
+		}
+		return textureSampleCount;
+	}
+
+	// Perspective-correct attributes of a quad (x, y relative to the setup origin)
+	template<typename Pipeline>
+	void Renderer::InterpolateQuad(const TriangleSetup& setup, const FloatV& x, const FloatV& y, QuadVertices& quadVertices) const
+	{
+		const FloatV w = FloatV{ 1.f } / setup.invW.Evaluate(x, y);
+
+		// Interpolate vertices 
+		if constexpr (Pipeline::hasUV)
+		{
+			const FloatV u = setup.uv[0].Evaluate(x, y) * w;
+			const FloatV v = setup.uv[1].Evaluate(x, y) * w;
+			u.Store(quadVertices.uv[0]);
+			v.Store(quadVertices.uv[1]);
+
+			// Screen space uv derivatives (mip selection), exact per pixel: d(U / Q) = (dU - u * dQ) / Q
+			alignas(32) float gradients[4][SIMD_WIDTH];
+			((FloatV{ setup.uv[0].dx } - u * FloatV{ setup.invW.dx }) * w).Store(gradients[0]);
+			((FloatV{ setup.uv[1].dx } - v * FloatV{ setup.invW.dx }) * w).Store(gradients[1]);
+			((FloatV{ setup.uv[0].dy } - u * FloatV{ setup.invW.dy }) * w).Store(gradients[2]);
+			((FloatV{ setup.uv[1].dy } - v * FloatV{ setup.invW.dy }) * w).Store(gradients[3]);
+			for (int lane{}; lane < SIMD_WIDTH; ++lane)
+				quadVertices.uvGradient[lane] = { gradients[0][lane], gradients[1][lane], gradients[2][lane], gradients[3][lane] };
+		}
+
+		if constexpr (Pipeline::hasNormal)
+		{
+			FloatV normal[3]{ setup.normal[0].Evaluate(x, y) * w, setup.normal[1].Evaluate(x, y) * w, setup.normal[2].Evaluate(x, y) * w };
+			Normalize(normal[0], normal[1], normal[2]);
+			for (int idx{}; idx < 3; ++idx)
+				normal[idx].Store(quadVertices.normal[idx]);
+		}
+
+		if constexpr (Pipeline::hasViewDirection)
+		{
+			FloatV viewDirection[3]{ setup.viewDirection[0].Evaluate(x, y) * w, setup.viewDirection[1].Evaluate(x, y) * w, setup.viewDirection[2].Evaluate(x, y) * w };
+			Normalize(viewDirection[0], viewDirection[1], viewDirection[2]);
+			for (int idx{}; idx < 3; ++idx)
+				viewDirection[idx].Store(quadVertices.viewDirection[idx]);
+		}
+
+		if constexpr (Pipeline::hasTangent)
+		{
+			FloatV tangent[3]{ setup.tangent[0].Evaluate(x, y) * w, setup.tangent[1].Evaluate(x, y) * w, setup.tangent[2].Evaluate(x, y) * w };
+			Normalize(tangent[0], tangent[1], tangent[2]);
+			for (int idx{}; idx < 3; ++idx)
+				tangent[idx].Store(quadVertices.tangent[idx]);
+		}
+	}
+
+	// Replaces the interpolated normal with the one from the normal map (tangent space)
+	void Renderer::ApplyNormalMap(Vertex_Out& vertex, const ColorRGB& sampledColor) const
+	{
+		Vector3 binormal = dae::Vector3::Cross(vertex.normal, vertex.tangent).Normalized();
+
+		dae::Matrix tangentSpaceAxis = { vertex.tangent, binormal, vertex.normal, Vector3::Zero };
+
+		Vector3 sampledNormal = { sampledColor.r, sampledColor.g, sampledColor.b };
+
+		//	sampledNormal /= 255;		//-> not necessary, texture sample output is already 0-1
+		sampledNormal = 2.f * sampledNormal - Vector3{ 1.f, 1.f, 1.f };
+		sampledNormal = tangentSpaceAxis.TransformVector(sampledNormal).Normalized();
+
+		vertex.normal = sampledNormal;
+	}
+
+	// Shading (texture samples are fetched per quad by the caller)
+	template<typename Pipeline>
 	ColorRGB Renderer::PixelShading(const Vertex_Out& vertex,
-		const Texture* pDiffuseTexture, const Texture* pSpecularTexture, const Texture* pGlossinessTexture)
+		const ColorRGB& diffuseColor, float specularReflectionCoefficient, float glossiness) const
 	{
 		ColorRGB lightContribution;
 
@@ -656,30 +1856,27 @@ namespace dae {
 		const float lightIntesity = 7.f;
 
 		// Specular
-		float specularReflectionCoefficient;
 		const float shininess = 25.f; // Multiply our sampled exponent with this;
-		float phongExponent;
-		Vector3 reflectVector;
-		float cosAlpha;
+		[[maybe_unused]] float phongExponent;
+		[[maybe_unused]] Vector3 reflectVector;
+		[[maybe_unused]] float cosAlpha;
 
 		// Ambient
 		const ColorRGB ambient = { .025f,.025f,.025f };
 			
 		if (lambertsCos > 0)
 		{
-			switch (m_CurrentShadingMode)
+			if constexpr (Pipeline::shadingMode == ShadingMode::ObservedArea) // Lambert Cosine
 			{
-			case dae::ShadingMode::ObservedArea: // Lambert Cosine
 				lightContribution = { lambertsCos, lambertsCos, lambertsCos };
-				break;
-
-			case dae::ShadingMode::Diffuse: // Lambert diffuse
-				lightContribution = (lambertsCos * lightIntesity * pDiffuseTexture->Sample(vertex.uv)) / M_PI;
-				break;
-
-			case dae::ShadingMode::Specular: // Phong specular
-				specularReflectionCoefficient = pSpecularTexture->Sample(vertex.uv).r;
-				phongExponent = pGlossinessTexture->Sample(vertex.uv).r * shininess;	// Since these textures store their values in grey scale, we can use the red channel only (optimized)
+			}
+			else if constexpr (Pipeline::shadingMode == ShadingMode::Diffuse) // Lambert diffuse
+			{
+				lightContribution = (lambertsCos * lightIntesity * diffuseColor) / M_PI;
+			}
+			else if constexpr (Pipeline::shadingMode == ShadingMode::Specular) // Phong specular
+			{
+				phongExponent = glossiness * shininess;	// Since these textures store their values in grey scale, only the red channel is sampled (optimized)
 
 				if (specularReflectionCoefficient > 0.0f)
 				{
@@ -690,15 +1887,14 @@ namespace dae {
 					lightContribution = specularReflectionCoefficient * (pow(cosAlpha, phongExponent)) * ColorRGB { 1.f, 1.f, 1.f };
 				}
 				else lightContribution = colors::Black;
-				break;
-
-			case dae::ShadingMode::Combined:
+			}
+			else if constexpr (Pipeline::shadingMode == ShadingMode::Combined)
+			{
 				// Lambert diffuse
-				lightContribution = (lambertsCos * lightIntesity * pDiffuseTexture->Sample(vertex.uv)) / M_PI;
+				lightContribution = (lambertsCos * lightIntesity * diffuseColor) / M_PI;
 
 				//Phong
-				specularReflectionCoefficient = pSpecularTexture->Sample(vertex.uv).r;
-				phongExponent = pGlossinessTexture->Sample(vertex.uv).r * shininess;	// Since these textures store their values in grey scale, we can use the red channel only (optimized)
+				phongExponent = glossiness * shininess;	// Since these textures store their values in grey scale, only the red channel is sampled (optimized)
 
 				if (specularReflectionCoefficient > 0.0f)
 				{
@@ -711,7 +1907,6 @@ namespace dae {
 
 				// Ambient
 				lightContribution += ambient;
-				break;
 			}
 		}
 		return lightContribution;
@@ -1,6 +1,10 @@
 #pragma once
 #include "Mesh.h"
 #include "Camera.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Simd.h"
+#include <cfloat>
 
 struct SDL_Window;
 struct SDL_Surface;
@@ -18,6 +22,296 @@ namespace dae
 		Combined = 3		// ObservedArea*Radiance*BRDF
 	};
 
+	// Compile-time configuration of the software pipeline: every stage is instantiated per configuration,
+	// so each one only computes, interpolates and samples what its shading mode, normal map and depth visualization read
+	template<ShadingMode Mode, bool IsNormalMapped, bool IsDepthOnly>
+	struct SoftwarePipeline
+	{
+		static constexpr ShadingMode shadingMode{ Mode };
+		static constexpr bool isDepthOnly{ IsDepthOnly };		// depth visualization: positions only, nothing gets shaded
+		static constexpr bool isDiffuseSampled{ !IsDepthOnly && (Mode == Diffuse || Mode == Combined) };
+		static constexpr bool isSpecularSampled{ !IsDepthOnly && (Mode == Specular || Mode == Combined) };
+		static constexpr bool hasNormalMap{ !IsDepthOnly && IsNormalMapped };
+
+		// attributes past the vertex stage
+		static constexpr bool hasNormal{ !IsDepthOnly };
+		static constexpr bool hasTangent{ hasNormalMap };
+		static constexpr bool hasViewDirection{ isSpecularSampled };
+		static constexpr bool hasUV{ hasNormalMap || isDiffuseSampled || isSpecularSampled };
+	};
+
+	// Partial coverage (alpha blended) meshes in every configuration: unlit, only the diffuse map and its alpha
+	struct PartialCoveragePipeline
+	{
+		static constexpr ShadingMode shadingMode{ Diffuse };
+		static constexpr bool isDepthOnly{ false };
+		static constexpr bool isDiffuseSampled{ true };
+		static constexpr bool isSpecularSampled{ false };
+		static constexpr bool hasNormalMap{ false };
+
+		static constexpr bool hasNormal{ false };
+		static constexpr bool hasTangent{ false };
+		static constexpr bool hasViewDirection{ false };
+		static constexpr bool hasUV{ true };
+	};
+
+	// How the software rasterizer composites partial coverage triangles
+	enum class TransparencyMode
+	{
+		Sorted,				// blended back to front per tile (average view depth of the triangle)
+		SubmissionOrder,	// blended in mesh order, like the hardware path
+		WeightedBlended		// order independent: weighted sums per pixel, resolved once per tile
+	};
+
+	// Weighted blended OIT accumulation of one pixel (McGuire and Bavoil 2013), the sums don't depend on the fragment order
+	struct OITAccumulation
+	{
+		ColorRGB color{};		// sum of color * alpha * weight
+		float alpha{};			// sum of alpha * weight
+		float revealage{ 1.f };	// product of (1 - alpha): how much of the opaque color still shows through
+	};
+
+	// Channel layout of the software back buffer (32 bit, 8 bits per channel), fixed once the surface exists:
+	// pixels are packed and unpacked inline instead of through SDL_MapRGB / SDL_GetRGB per pixel
+	struct PixelLayout
+	{
+		uint32_t redShift{}, greenShift{}, blueShift{};
+		uint32_t alphaMask{};	// SDL_MapRGB makes every pixel opaque
+
+		uint32_t Pack(uint8_t r, uint8_t g, uint8_t b) const
+		{
+			return static_cast<uint32_t>(r) << redShift | static_cast<uint32_t>(g) << greenShift | static_cast<uint32_t>(b) << blueShift | alphaMask;
+		};
+		uint8_t GetRed(uint32_t pixel) const { return static_cast<uint8_t>(pixel >> redShift); };
+		uint8_t GetGreen(uint32_t pixel) const { return static_cast<uint8_t>(pixel >> greenShift); };
+		uint8_t GetBlue(uint32_t pixel) const { return static_cast<uint8_t>(pixel >> blueShift); };
+		ColorRGB Unpack(uint32_t pixel) const { return { GetRed(pixel) / 255.f, GetGreen(pixel) / 255.f, GetBlue(pixel) / 255.f }; };
+	};
+
+	// Per-frame counters of the software rasterizer
+	struct FrameStats
+	{
+		uint32_t triangleCount{};	// triangles submitted
+		uint32_t backfaceCulledCount{};		// facing away for the current CullMode
+		uint32_t zeroAreaCulledCount{};		// degenerate on the subpixel grid
+		uint32_t offscreenCulledCount{};	// outside the frustum or not covering a pixel center
+		uint32_t clippedCount{};			// crossed the near/far plane or the guard band
+		uint64_t pixelCount{};		// pixels that passed the depth test
+		uint64_t shadedPixelCount{};	// pixels that ran PixelShading (once per visible pixel when deferred)
+		uint64_t blendedPixelCount{};	// partial coverage fragments that passed the depth test with alpha > 0
+		uint64_t testedPixelCount{};	// covered pixels that went through the depth test (opaque + partial coverage)
+		uint64_t textureSampleCount{};	// filtered texture fetches (one per lane and map)
+	};
+
+	// Software rasterizer screen tiles
+	constexpr int TILE_SIZE{ 32 };
+	// Vertices per vertex transformation job
+	constexpr size_t VERTEX_CHUNK_SIZE{ 4096 };
+
+	// Screen positions are snapped to 1/SUBPIXEL_SCALE of a pixel before rasterization
+	constexpr int SUBPIXEL_BITS{ 8 };
+	constexpr int SUBPIXEL_SCALE{ 1 << SUBPIXEL_BITS };
+	// Vertices further off screen than this (in pixels) would overflow the fixed point edge functions
+	constexpr float SUBPIXEL_RANGE{ 16384.f };
+	// Triangles are only clipped in x/y when they reach this far (in pixels) beyond the screen
+	constexpr float GUARD_BAND{ SUBPIXEL_RANGE / 2 };
+
+	// Clip space outcodes (-w <= x, y <= w and 0 <= z <= w)
+	constexpr uint32_t CLIP_LEFT{ 1 << 0 };
+	constexpr uint32_t CLIP_RIGHT{ 1 << 1 };
+	constexpr uint32_t CLIP_BOTTOM{ 1 << 2 };
+	constexpr uint32_t CLIP_TOP{ 1 << 3 };
+	constexpr uint32_t CLIP_NEAR{ 1 << 4 };
+	constexpr uint32_t CLIP_FAR{ 1 << 5 };
+	constexpr uint32_t GUARD_LEFT{ 1 << 6 };
+	constexpr uint32_t GUARD_RIGHT{ 1 << 7 };
+	constexpr uint32_t GUARD_BOTTOM{ 1 << 8 };
+	constexpr uint32_t GUARD_TOP{ 1 << 9 };
+	constexpr uint32_t CLIP_FRUSTUM{ CLIP_LEFT | CLIP_RIGHT | CLIP_BOTTOM | CLIP_TOP | CLIP_NEAR | CLIP_FAR };
+	// planes that really get clipped against, the others are handled by the rasterizer
+	constexpr uint32_t CLIP_NEEDED{ CLIP_NEAR | CLIP_FAR | GUARD_LEFT | GUARD_RIGHT | GUARD_BOTTOM | GUARD_TOP };
+
+	// Interpolant that is linear in screen space: value = origin + dx * (x - x0) + dy * (y - y0)
+	struct AttributePlane
+	{
+		float origin{}, dx{}, dy{};
+
+		float Evaluate(float x, float y) const { return origin + dx * x + dy * y; };
+		FloatV Evaluate(const FloatV& x, const FloatV& y) const { return FloatV{ origin } + FloatV{ dx } * x + FloatV{ dy } * y; };
+	};
+
+	// Everything the pixel loop needs, computed once per triangle
+	struct TriangleSetup
+	{
+		// fixed point edge functions e = a * x + b * y + c (top-left bias folded into c),
+		// a pixel is covered when all three are >= 0
+		int64_t edgeA[3]{}, edgeB[3]{}, edgeC[3]{};
+
+		float originX{}, originY{};	// first vertex, the planes are relative to it
+		AttributePlane invDepth{};	// 1 / z
+		AttributePlane invW{};		// 1 / w (perspective correction)
+		AttributePlane uv[2]{};		// attributes are stored divided by w
+		AttributePlane normal[3]{};
+		AttributePlane tangent[3]{};
+		AttributePlane viewDirection[3]{};
+	};
+
+	// Pixels are rasterized in quads of QUAD_WIDTH x QUAD_HEIGHT, one SIMD lane per pixel (row-major within the quad)
+	constexpr int QUAD_HEIGHT{ SIMD_WIDTH == 1 ? 1 : 2 };
+	constexpr int QUAD_WIDTH{ SIMD_WIDTH / QUAD_HEIGHT };
+	constexpr int FULL_QUAD_MASK{ (1 << SIMD_WIDTH) - 1 };
+
+	// Pixel position of every lane within a quad
+	inline FloatV GetQuadLaneX()
+	{
+		alignas(32) float offsets[SIMD_WIDTH];
+		for (int lane{}; lane < SIMD_WIDTH; ++lane)
+			offsets[lane] = static_cast<float>(lane % QUAD_WIDTH);
+		return FloatV::Load(offsets);
+	}
+	inline FloatV GetQuadLaneY()
+	{
+		alignas(32) float offsets[SIMD_WIDTH];
+		for (int lane{}; lane < SIMD_WIDTH; ++lane)
+			offsets[lane] = static_cast<float>(lane / QUAD_WIDTH);
+		return FloatV::Load(offsets);
+	}
+
+	// Triangles are classified per BLOCK_SIZE x BLOCK_SIZE block of a tile before any quad is touched
+	constexpr int BLOCK_SIZE{ 8 };
+	static_assert(TILE_SIZE % BLOCK_SIZE == 0, "tiles must hold whole blocks");
+	static_assert(BLOCK_SIZE % QUAD_WIDTH == 0 && BLOCK_SIZE % QUAD_HEIGHT == 0, "blocks must hold whole quads");
+	// Hi-Z only rejects a block when its nearest depth is clearly behind (rounding of the plane evaluation)
+	constexpr float HIZ_TOLERANCE{ 1.0001f };
+
+	// Visibility buffer value of pixels no triangle covers
+	constexpr uint32_t NO_TRIANGLE{ UINT32_MAX };
+
+	// Multisampling (software + hardware render target): coverage and depth per sample, shading once per pixel
+	constexpr int MAX_SAMPLE_COUNT{ 8 };
+
+	// Sample position, offset from the pixel center in 1/SAMPLE_POSITION_SCALE of a pixel
+	struct SamplePosition
+	{
+		int x{}, y{};
+	};
+	constexpr int SAMPLE_POSITION_SCALE{ 16 };
+
+	// Standard D3D11 sample patterns, so both rasterizers cover the same sub-pixel positions
+	constexpr SamplePosition SAMPLE_PATTERN_1[1]{ { 0, 0 } };
+	constexpr SamplePosition SAMPLE_PATTERN_2[2]{ { 4, 4 }, { -4, -4 } };
+	constexpr SamplePosition SAMPLE_PATTERN_4[4]{ { -2, -6 }, { 6, -2 }, { -6, 2 }, { 2, 6 } };
+	constexpr SamplePosition SAMPLE_PATTERN_8[8]{ { 1, -3 }, { -1, 3 }, { 5, 1 }, { -3, -5 }, { -5, 5 }, { -7, -1 }, { 3, 7 }, { 7, -7 } };
+
+	inline const SamplePosition* GetSamplePattern(int sampleCount)
+	{
+		switch (sampleCount)
+		{
+		case 2: return SAMPLE_PATTERN_2;
+		case 4: return SAMPLE_PATTERN_4;
+		case 8: return SAMPLE_PATTERN_8;
+		default: return SAMPLE_PATTERN_1;
+		}
+	}
+
+	// Interpolated attributes of one quad, one lane per pixel
+	struct QuadVertices
+	{
+		alignas(32) float uv[2][SIMD_WIDTH];
+		alignas(32) float normal[3][SIMD_WIDTH];
+		alignas(32) float tangent[3][SIMD_WIDTH];
+		alignas(32) float viewDirection[3][SIMD_WIDTH];
+		UVGradient uvGradient[SIMD_WIDTH];
+
+		Vertex_Out GetVertex(int lane) const
+		{
+			Vertex_Out vertex{};
+			vertex.uv = { uv[0][lane], uv[1][lane] };
+			vertex.normal = { normal[0][lane], normal[1][lane], normal[2][lane] };
+			vertex.tangent = { tangent[0][lane], tangent[1][lane], tangent[2][lane] };
+			vertex.viewDirection = { viewDirection[0][lane], viewDirection[1][lane], viewDirection[2][lane] };
+			return vertex;
+		};
+	};
+
+	// One filtered sample per quad lane, through the batched sampler entry point matching the lane count
+	inline void SampleQuad(const Texture* pTexture, const QuadVertices& quadVertices, FilteringMethod filteringMethod, ColorRGB* pColors)
+	{
+		if constexpr (SIMD_WIDTH == 8)
+			pTexture->Sample8(quadVertices.uv[0], quadVertices.uv[1], quadVertices.uvGradient, filteringMethod, pColors);
+		else if constexpr (SIMD_WIDTH == 4)
+			pTexture->Sample4(quadVertices.uv[0], quadVertices.uv[1], quadVertices.uvGradient, filteringMethod, pColors);
+		else
+			pColors[0] = pTexture->Sample({ quadVertices.uv[0][0], quadVertices.uv[1][0] }, quadVertices.uvGradient[0], filteringMethod);
+	}
+	inline void SampleQuadRed(const Texture* pTexture, const QuadVertices& quadVertices, FilteringMethod filteringMethod, float* pValues)
+	{
+		if constexpr (SIMD_WIDTH == 8)
+			pTexture->SampleRed8(quadVertices.uv[0], quadVertices.uv[1], quadVertices.uvGradient, filteringMethod, pValues);
+		else if constexpr (SIMD_WIDTH == 4)
+			pTexture->SampleRed4(quadVertices.uv[0], quadVertices.uv[1], quadVertices.uvGradient, filteringMethod, pValues);
+		else
+			pValues[0] = pTexture->SampleRed({ quadVertices.uv[0][0], quadVertices.uv[1][0] }, quadVertices.uvGradient[0], filteringMethod);
+	}
+	inline void SampleQuadColorAlpha(const Texture* pTexture, const QuadVertices& quadVertices, FilteringMethod filteringMethod, ColorAlphaSample* pSamples)
+	{
+		if constexpr (SIMD_WIDTH == 8)
+			pTexture->SampleColorAlpha8(quadVertices.uv[0], quadVertices.uv[1], quadVertices.uvGradient, filteringMethod, pSamples);
+		else if constexpr (SIMD_WIDTH == 4)
+			pTexture->SampleColorAlpha4(quadVertices.uv[0], quadVertices.uv[1], quadVertices.uvGradient, filteringMethod, pSamples);
+		else
+			pSamples[0] = pTexture->SampleColorAlpha({ quadVertices.uv[0][0], quadVertices.uv[1][0] }, quadVertices.uvGradient[0], filteringMethod);
+	}
+	inline void SampleQuadMaterial(const Texture* pTexture, const QuadVertices& quadVertices, FilteringMethod filteringMethod, MaterialSample* pSamples)
+	{
+		if constexpr (SIMD_WIDTH == 8)
+			pTexture->SampleMaterial8(quadVertices.uv[0], quadVertices.uv[1], quadVertices.uvGradient, filteringMethod, pSamples);
+		else if constexpr (SIMD_WIDTH == 4)
+			pTexture->SampleMaterial4(quadVertices.uv[0], quadVertices.uv[1], quadVertices.uvGradient, filteringMethod, pSamples);
+		else
+			pSamples[0] = pTexture->SampleMaterial({ quadVertices.uv[0][0], quadVertices.uv[1][0] }, quadVertices.uvGradient[0], filteringMethod);
+	}
+
+	// Outcome of primitive assembly
+	enum class TriangleCull
+	{
+		Visible,
+		Backface,
+		ZeroArea,
+		Offscreen
+	};
+
+	struct BinnedTriangle
+	{
+		int meshIdx{};
+		uint32_t vertexIndices[3]{};	// into the mesh vertices, or into the clipped vertices when it got clipped
+		int minX{}, minY{}, maxX{}, maxY{};	// screen bounding box (pixels whose center can be covered)
+		float depth{};		// average view depth of the vertices (back-to-front order of partial coverage triangles)
+		TriangleSetup setup{};
+	};
+
+	// Coarse depth of one BLOCK_SIZE x BLOCK_SIZE block (Hi-Z)
+	struct HiZBlock
+	{
+		float minDepth{ FLT_MAX };
+		float maxDepth{ FLT_MAX };			// includes cleared pixels -> nothing behind it can be visible
+		float maxVisibleDepth{ 0.f };		// only pixels that got drawn
+	};
+
+	struct Tile
+	{
+		int minX{}, minY{}, maxX{}, maxY{};
+		std::vector<uint32_t> triangleIndices{};	// into the binned triangles, in submission order
+		std::vector<uint32_t> transparentTriangleIndices{};	// partial coverage meshes, blended after the opaque ones
+		uint64_t pixelCount{};
+		uint64_t shadedPixelCount{};
+		uint64_t blendedPixelCount{};
+		uint64_t testedPixelCount{};
+		uint64_t textureSampleCount{};
+		float minDepth{}, maxDepth{};	// depth range of what got drawn
+		double rasterizationMs{}, shadingMs{};	// thread time of the tile jobs
+	};
+
 	// ANSI color codes
 	const std::string STRINGCOLOR_RESET = "\033[0m";
 	const std::string STRINGCOLOR_SHARED_CYAN = "\033[36m";
@@ -30,7 +324,8 @@ namespace dae
 	public:
 		// Ctor and Dtor
 		//==============
-		Renderer(SDL_Window* pWindow);
+		Renderer(SDL_Window* pWindow, int sampleCount = 1);
+		Renderer(int width, int height, const std::string& meshName, uint32_t threadCount = 0, int sampleCount = 1);	// headless: software only, renders offscreen
 		~Renderer();
 
 		// Rule Of 5
@@ -43,17 +338,69 @@ namespace dae
 		void Update(const Timer* pTimer);
 		void Render() ;
 
+		// Getters
+		Camera& GetCamera() { return m_Camera; };
+		SDL_Surface* GetBackBuffer() const { return m_pBackBuffer; };
+		const FrameStats& GetFrameStats() const { return m_FrameStats; };
+		Profiler& GetProfiler() { return m_Profiler; };
+		uint32_t GetThreadCount() const { return m_pJobSystem->GetThreadCount(); };
+		int GetSampleCount() const { return m_SampleCount; };
+
+		// Setters
+		void SetSoftwareCullMode(CullMode cullMode) { m_CurrentCullMode = cullMode; };	// headless only, the hardware path keeps its rasterizer state
+		void SetFilteringMethod(FilteringMethod filteringMethod) { m_FilteringMethod = filteringMethod; };
+		void SetTexelLayout(TexelLayout texelLayout);
+		void SetShadingMode(ShadingMode shadingMode) { m_CurrentShadingMode = shadingMode; };
+		void SetNormalMapVisible(bool isNormalMapVisible) { m_IsNormalMapVisible = isNormalMapVisible; };
+		void SetDepthVisualization(bool isDepthVisualization) { m_ShowDepthVisualization = isDepthVisualization; };
+		void SetFireMeshVisible(bool isFireMeshVisible) { m_ShowFireMesh = isFireMeshVisible; };
+		void SetTransparencyMode(TransparencyMode transparencyMode) { m_TransparencyMode = transparencyMode; };
+
 
 		// SOFTWARE SPECIFIC RENDERING
 		//=============================
 
-		bool RenderCheckPixel(const Vector2& pixel,
-			const Vertex_Out& vertex0, const Vertex_Out& vertex1, const Vertex_Out& vertex2,
-			Vertex_Out& interpolatedVertex, const Texture* pNormaltexture);
-		void VertexTransformationFunction(const std::vector<Vertex_In>& vertices_in, std::vector<Vertex_Out>& vertices_out, const Matrix& worldMatrix) const;
-		void VertexNDCToScreen(Vector4& vertexPosition) const;
+		// Stages templated on a SoftwarePipeline, RenderSoftware picks the instantiation of the current toggles
+		void RenderSoftware();
+		template<ShadingMode Mode>
+		void RenderSoftware();
+		template<typename Pipeline>
+		void RenderSoftwareFrame();
+
+		uint32_t GetClipCode(const Vector4& clipPosition) const;
+		template<typename Pipeline>
+		void ClipTriangle(const BinnedTriangle& triangle, uint32_t clipCodes);
+		bool IsFaceCulled(bool isClockwise) const;
+		template<typename Pipeline>
+		TriangleCull SetupTriangle(const VertexBuffer_Out& vertices, BinnedTriangle& triangle) const;
+		void AddToTiles(const BinnedTriangle& triangle);
+		template<typename Pipeline>
+		void InterpolateQuad(const TriangleSetup& setup, const FloatV& x, const FloatV& y, QuadVertices& quadVertices) const;
+		template<typename Pipeline>
+		int ShadeQuad(const BinnedTriangle& triangle, int qx, int qy, int lanes, const int* pSampleLanes, const FloatV& x, const FloatV& y, QuadVertices& quadVertices);	// returns the texture samples
+		template<typename Pipeline>
+		void ShadeVisibleTile(Tile& tile);
+		void ApplyNormalMap(Vertex_Out& vertex, const ColorRGB& sampledColor) const;
+		template<typename Pipeline>
+		void VertexTransformationFunction(const VertexBuffer_In& vertices_in, VertexBuffer_Out& vertices_out, const Matrix& worldMatrix) const;
+		template<typename Pipeline>
+		void TransformVertices(const VertexBuffer_In& vertices_in, VertexBuffer_Out& vertices_out, const Matrix& worldMatrix, size_t begin, size_t end) const;
+		template<typename Pipeline>
+		void BinTriangles(int meshIdx);
+		template<typename Pipeline>
+		void RenderTile(Tile& tile);
+		template<typename QuadFunction>
+		uint64_t RasterizeTriangle(uint32_t triangleIdx, const Tile& tile, const QuadFunction& rasterizeQuad);	// returns the covered pixels
+		template<bool IsDepthWritten>
+		int DepthTestQuad(const TriangleSetup& setup, const Tile& tile, int qx, int qy, const int* pSampleCoverage, int* pSampleVisible);
+		void ResolveTile(const Tile& tile);
+		void BlendTransparentTile(Tile& tile);
+		void ResolveTransparentTile(const Tile& tile);
+		void UpdateHiZBlock(int blockX, int blockY, const Tile& tile);
+		void ShadeDepthTile(Tile& tile, float minDepth, float maxDepth);
+		template<typename Pipeline>
 		ColorRGB PixelShading(const Vertex_Out& vertex,
-			const Texture* pDiffuseTexture, const Texture* pSpecularTexture, const Texture* pGlossinessTexture);
+			const ColorRGB& diffuseColor, float specularReflectionCoefficient, float glossiness) const;
 
 
 		// TOGGLES
@@ -62,9 +409,11 @@ namespace dae
 		//shared functions
 		void SwitchRasterizerMode() {
 			std::cout << STRINGCOLOR_SHARED_CYAN << " **(SHARED) ";
+#if ENABLE_DIRECTX
 			m_IsSoftwareRasterizer = !m_IsSoftwareRasterizer;
+#endif
 
-			if (m_IsSoftwareRasterizer)	std::cout << "Rasterizer Mode = SOFTWARE\n" << STRINGCOLOR_RESET;
+			if (m_IsSoftwareRasterizer)	std::cout << "Rasterizer Mode = SOFTWARE" << (ENABLE_DIRECTX ? "\n" : " (built without DirectX)\n") << STRINGCOLOR_RESET;
 			else std::cout << "Rasterizer Mode = HARDWARE\n" << STRINGCOLOR_RESET;
 		};  //F1
 		void ToggleRotation() {
@@ -73,63 +422,73 @@ namespace dae
 			if (m_IsRotating)	std::cout << "Vehicle Rotation ON\n"<<STRINGCOLOR_RESET;
 			else 	std::cout << "Vehicle Rotation OFF\n"<<STRINGCOLOR_RESET;
 		};
+		void SwitchFilterMode()	// software sampler + hardware sampler state
+		{
+			std::cout << STRINGCOLOR_SHARED_CYAN << " **(SHARED) ";
+			switch (m_FilteringMethod)
+			{
+			case dae::FilteringMethod::Point:
+				m_FilteringMethod = FilteringMethod::Linear;
+				std::cout << "Sampler Filter = LINEAR\n" << STRINGCOLOR_RESET;
+				break;
+			case dae::FilteringMethod::Linear:
+				m_FilteringMethod = FilteringMethod::Anisotropic;
+				std::cout << "Sampler Filter = ANISOTRPIC\n" << STRINGCOLOR_RESET;
+				break;
+			case dae::FilteringMethod::Anisotropic:
+				m_FilteringMethod = FilteringMethod::Point;
+				std::cout << "Sampler Filter = POINT\n" << STRINGCOLOR_RESET;
+				break;
+			default:
+				m_FilteringMethod = FilteringMethod::Point;
+				std::cout << "Sampler Filter = POINT\n" << STRINGCOLOR_RESET;
+				break;
+			}
+		};
 		void SwitchCullMode()
 		{
 			std::cout << STRINGCOLOR_SHARED_CYAN << " **(SHARED) ";
 
-			// Delete current rasterizer state
-			if (m_pRasterizerState)
-				m_pRasterizerState->Release();
-			D3D11_RASTERIZER_DESC rasterizerDesc = {};
-			HRESULT result{};
-
+			CullMode cullMode{ CullMode::None };
 			switch (m_CurrentCullMode)
 			{
-			case CullMode::None:
-				// Create new rasterizerstate
-				rasterizerDesc.CullMode = D3D11_CULL_BACK;
-				rasterizerDesc.FillMode = D3D11_FILL_SOLID;
-
-				result = m_pDevice->CreateRasterizerState(&rasterizerDesc, &m_pRasterizerState);
-
-				if (FAILED(result))//check if failed
-				{
-					std::cout << "Switching cullmode failed!! :(\n";
-					return;
-				}
+			case CullMode::None:	cullMode = CullMode::Back;	break;
+			case CullMode::Back:	cullMode = CullMode::Front;	break;
+			case CullMode::Front:	cullMode = CullMode::None;	break;
+			}
 
-				std::cout << "CullMode = BACK\n"<<STRINGCOLOR_RESET;
-				m_CurrentCullMode = CullMode::Back;	//update enum
-				break;
-			case CullMode::Back:
-				rasterizerDesc.CullMode = D3D11_CULL_FRONT;
+#if ENABLE_DIRECTX
+			if (m_pDevice)
+			{
+				// Delete current rasterizer state + create the new one
+				if (m_pRasterizerState)
+					m_pRasterizerState->Release();
+				D3D11_RASTERIZER_DESC rasterizerDesc = {};
+				rasterizerDesc.MultisampleEnable = m_HardwareSampleCount > 1;
 				rasterizerDesc.FillMode = D3D11_FILL_SOLID;
-
-				result = m_pDevice->CreateRasterizerState(&rasterizerDesc, &m_pRasterizerState);
-				if (FAILED(result))
+				switch (cullMode)
 				{
-					std::cout << "Switching cullmode failed!! :(\n";
-					return;
+				case CullMode::Back:	rasterizerDesc.CullMode = D3D11_CULL_BACK;	break;
+				case CullMode::Front:	rasterizerDesc.CullMode = D3D11_CULL_FRONT;	break;
+				case CullMode::None:	rasterizerDesc.CullMode = D3D11_CULL_NONE;	break;
 				}
 
-				std::cout << "CullMode = FRONT\n"<<STRINGCOLOR_RESET;
-				m_CurrentCullMode = CullMode::Front;
-				break;
-			case CullMode::Front:
-				rasterizerDesc.CullMode = D3D11_CULL_NONE;
-				rasterizerDesc.FillMode = D3D11_FILL_SOLID;
-
-				result = m_pDevice->CreateRasterizerState(&rasterizerDesc, &m_pRasterizerState);
-				if (FAILED(result))
+				const HRESULT result = m_pDevice->CreateRasterizerState(&rasterizerDesc, &m_pRasterizerState);
+				if (FAILED(result))//check if failed
 				{
 					std::cout << "Switching cullmode failed!! :(\n";
 					return;
 				}
+			}
+#endif
 
-				std::cout << "CullMode = NONE\n"<<STRINGCOLOR_RESET;
-				m_CurrentCullMode = CullMode::None;
-				break;
+			switch (cullMode)
+			{
+			case CullMode::Back:	std::cout << "CullMode = BACK\n" << STRINGCOLOR_RESET;	break;
+			case CullMode::Front:	std::cout << "CullMode = FRONT\n" << STRINGCOLOR_RESET;	break;
+			case CullMode::None:	std::cout << "CullMode = NONE\n" << STRINGCOLOR_RESET;	break;
 			}
+			m_CurrentCullMode = cullMode;	//update enum
 		}
 		void ToggleUniformColor() {
 			std::cout << STRINGCOLOR_SHARED_CYAN << " **(SHARED) ";
@@ -146,42 +505,12 @@ namespace dae
 			else std::cout << "Print FPS OFF\n"<<STRINGCOLOR_RESET;
 		};
 	
-		//hardware-only
 		void ToggleFireMesh() {
-			if (!m_IsSoftwareRasterizer)
-			{
-				std::cout << STRINGCOLOR_HARDWARE_YELLOW << " **(HARDWARE) ";
-				m_ShowFireMesh = !m_ShowFireMesh;
+			std::cout << STRINGCOLOR_SHARED_CYAN << " **(SHARED) ";
+			m_ShowFireMesh = !m_ShowFireMesh;
 
-				if (m_ShowFireMesh)	std::cout << "FireFX ON\n" << STRINGCOLOR_RESET;
-				else std::cout << "FireFX OFF\n" << STRINGCOLOR_RESET;
-			}
-		};
-		void SwitchFilterMode()
-		{
-			if (!m_IsSoftwareRasterizer)
-			{
-				std::cout << STRINGCOLOR_HARDWARE_YELLOW << " **(HARDWARE) ";
-				switch (m_FilteringMethod)
-				{
-				case dae::FilteringMethod::Point:
-					m_FilteringMethod = FilteringMethod::Linear;
-					std::cout << "Sampler Filter = LINEAR\n" << STRINGCOLOR_RESET;
-					break;
-				case dae::FilteringMethod::Linear:
-					m_FilteringMethod = FilteringMethod::Anisotropic;
-					std::cout << "Sampler Filter = ANISOTRPIC\n" << STRINGCOLOR_RESET;
-					break;
-				case dae::FilteringMethod::Anisotropic:
-					m_FilteringMethod = FilteringMethod::Point;
-					std::cout << "Sampler Filter = POINT\n" << STRINGCOLOR_RESET;
-					break;
-				default:
-					m_FilteringMethod = FilteringMethod::Point;
-					std::cout << "Sampler Filter = POINT\n" << STRINGCOLOR_RESET;
-					break;
-				}
-			}
+			if (m_ShowFireMesh)	std::cout << "FireFX ON\n" << STRINGCOLOR_RESET;
+			else std::cout << "FireFX OFF\n" << STRINGCOLOR_RESET;
 		};
 		
 		//software-only
@@ -245,11 +574,21 @@ namespace dae
 				else std::cout << "BoundingBox Visualization OFF\n" << STRINGCOLOR_RESET;
 			}
 		};
+		void ToggleDeferredShading() {
+			if (m_IsSoftwareRasterizer)
+			{
+				std::cout << STRINGCOLOR_SOFTWARE_GREEN << " **(SOFTWARE) ";
+				m_IsDeferredShading = !m_IsDeferredShading;
+
+				if (m_IsDeferredShading) std::cout << "Deferred Shading ON\n" << STRINGCOLOR_RESET;
+				else std::cout << "Deferred Shading OFF\n" << STRINGCOLOR_RESET;
+			}
+		};
 
 		bool m_IsPrintingFPS{ 0 };
 
 	private:
-		bool m_IsSoftwareRasterizer{};
+		bool m_IsSoftwareRasterizer{ !ENABLE_DIRECTX };	// starts in hardware mode when there is one
 		bool m_IsRotating{1};	
 		bool m_ShowFireMesh{ 1 };	
 		FilteringMethod m_FilteringMethod{}; 
@@ -257,6 +596,8 @@ namespace dae
 		bool m_IsNormalMapVisible{ 1 };
 		bool m_ShowDepthVisualization{ 0 };
 		bool m_ShowAABBVisualization{ 0 };
+		bool m_IsDeferredShading{ 0 };		// rasterize into the visibility buffer first, shade every visible pixel once
+		TransparencyMode m_TransparencyMode{ TransparencyMode::Sorted };
 		CullMode m_CurrentCullMode{None};	//F9 -shared
 		bool m_IsUniformColor{0};
 		
@@ -268,7 +609,14 @@ namespace dae
 		int m_Width{};
 		int m_Height{};
 
-		bool m_IsInitialized{ false };
+#if ENABLE_DIRECTX
+		bool m_IsInitialized{ false };	// DirectX
+#endif
+		bool m_IsHeadless{ false };
+
+		void InitializeSoftwareBuffers();
+		uint32_t* GetSampleColors(int sampleIdx) { return m_SampleCount == 1 ? m_pBackBufferPixels : m_SampleColorBuffer.data() + sampleIdx * m_SamplePlaneSize; };
+		void InitializeMeshes(const std::string& meshName);
 
 		std::vector<Mesh*> m_pMeshesVector;
 		std::vector<MeshStruct> m_MeshesStructVector;
@@ -283,11 +631,34 @@ namespace dae
 		// SOFTWARE
 		//===========	
 
-		// buffers
+		// buffers (per sample ones hold m_SampleCount planes of m_SamplePlaneSize, sample after sample)
 		SDL_Surface* m_pFrontBuffer{ nullptr };
 		SDL_Surface* m_pBackBuffer{ nullptr };
 		uint32_t* m_pBackBufferPixels{};
-		std::vector <float> m_DepthBuffer;
+		PixelLayout m_BackBufferLayout{};
+		std::vector <float> m_DepthBuffer;		// per sample
+		std::vector<HiZBlock> m_HiZBuffer;		// one per BLOCK_SIZE x BLOCK_SIZE pixels
+		std::vector<uint32_t> m_VisibilityBuffer;	// binned triangle per sample (deferred shading)
+		std::vector<uint32_t> m_SampleColorBuffer;	// color per sample, resolved into the back buffer per tile (MSAA only)
+		std::vector<OITAccumulation> m_OITBuffer;	// weighted blended transparency
+		int m_HiZWidth{};
+		uint32_t m_ClearColor{};
+
+		// multisampling
+		int m_SampleCount{ 1 };		// 1, 2, 4 or 8
+		size_t m_SamplePlaneSize{};
+		float m_SampleOffsetX[MAX_SAMPLE_COUNT]{};	// in pixels
+		float m_SampleOffsetY[MAX_SAMPLE_COUNT]{};
+
+		// tiles
+		std::vector<Tile> m_Tiles;
+		int m_TileCountX{};
+		std::vector<BinnedTriangle> m_BinnedTriangles;
+		VertexBuffer_Out m_ClippedVertices;		// new vertices of clipped triangles (this frame)
+		std::unique_ptr<JobSystem> m_pJobSystem;
+
+		FrameStats m_FrameStats{};
+		Profiler m_Profiler{};
 
 		Matrix m_WorldViewProjectionMatrix;
 
@@ -300,6 +671,7 @@ namespace dae
 
 
 
+#if ENABLE_DIRECTX
 		//DIRECTX
 		//======
 		HRESULT InitializeDirectX();
@@ -310,6 +682,7 @@ namespace dae
 
 		//SwapChain
 		IDXGISwapChain* m_pSwapChain = nullptr;
+		int m_HardwareSampleCount{ 1 };	// m_SampleCount, or lower when the device doesn't support it
 		
 		//DepthStencil (DS) & DepthStencilView (DSV)
 		ID3D11Texture2D* m_pDepthStencilBuffer = nullptr;
@@ -320,7 +693,8 @@ namespace dae
 		ID3D11RenderTargetView* m_pRenderTargetView = nullptr;
 
 		//RasterizerState
-		ID3D11RasterizerState* m_pRasterizerState;	//F9 -shared
+		ID3D11RasterizerState* m_pRasterizerState = nullptr;	//F9 -shared
+#endif
 
 
 
@@ -0,0 +1,133 @@
+#pragma once
+
+//includes
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+// Lane width of the software pipeline, picked at compile time:
+// AVX -> 8 lanes, SSE2 (always there on x64) -> 4 lanes, anything else -> 1 lane (scalar fallback)
+#if defined(__AVX__)
+#define DAE_SIMD_AVX 1
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(__SSE2__)
+#define DAE_SIMD_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace dae
+{
+#if defined(DAE_SIMD_AVX)
+	constexpr int SIMD_WIDTH{ 8 };
+	using NativeFloat = __m256;
+#elif defined(DAE_SIMD_SSE)
+	constexpr int SIMD_WIDTH{ 4 };
+	using NativeFloat = __m128;
+#else
+	constexpr int SIMD_WIDTH{ 1 };
+	using NativeFloat = float;
+#endif
+
+	// SIMD_WIDTH floats, comparisons return lane masks (all bits set = true)
+	struct FloatV
+	{
+		NativeFloat v;
+
+		FloatV() = default;
+		FloatV(NativeFloat _v) : v{ _v } {}
+
+		// lane i is set when bit i of bits is set
+		static FloatV LaneMask(int bits)
+		{
+			alignas(32) float lanes[SIMD_WIDTH];
+			for (int lane{}; lane < SIMD_WIDTH; ++lane)
+			{
+				const uint32_t laneBits = (bits >> lane) & 1 ? 0xFFFFFFFFu : 0u;
+				std::memcpy(&lanes[lane], &laneBits, sizeof(float));
+			}
+			return Load(lanes);
+		}
+
+#if defined(DAE_SIMD_AVX)
+		explicit FloatV(float s) : v{ _mm256_set1_ps(s) } {}
+
+		static FloatV Load(const float* p) { return _mm256_loadu_ps(p); }
+		void Store(float* p) const { _mm256_storeu_ps(p, v); }
+		static FloatV LaneIndex() { return _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f); }
+
+		FloatV operator+(const FloatV& o) const { return _mm256_add_ps(v, o.v); }
+		FloatV operator-(const FloatV& o) const { return _mm256_sub_ps(v, o.v); }
+		FloatV operator*(const FloatV& o) const { return _mm256_mul_ps(v, o.v); }
+		FloatV operator/(const FloatV& o) const { return _mm256_div_ps(v, o.v); }
+		FloatV operator&(const FloatV& o) const { return _mm256_and_ps(v, o.v); }
+		FloatV operator|(const FloatV& o) const { return _mm256_or_ps(v, o.v); }
+		FloatV operator<(const FloatV& o) const { return _mm256_cmp_ps(v, o.v, _CMP_LT_OQ); }
+		FloatV operator<=(const FloatV& o) const { return _mm256_cmp_ps(v, o.v, _CMP_LE_OQ); }
+		FloatV operator>(const FloatV& o) const { return _mm256_cmp_ps(v, o.v, _CMP_GT_OQ); }
+		FloatV operator>=(const FloatV& o) const { return _mm256_cmp_ps(v, o.v, _CMP_GE_OQ); }
+
+		static FloatV Min(const FloatV& a, const FloatV& b) { return _mm256_min_ps(a.v, b.v); }
+		static FloatV Max(const FloatV& a, const FloatV& b) { return _mm256_max_ps(a.v, b.v); }
+		static FloatV Sqrt(const FloatV& a) { return _mm256_sqrt_ps(a.v); }
+		static FloatV Select(const FloatV& mask, const FloatV& a, const FloatV& b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }	// mask ? a : b
+		static int MoveMask(const FloatV& mask) { return _mm256_movemask_ps(mask.v); }
+#elif defined(DAE_SIMD_SSE)
+		explicit FloatV(float s) : v{ _mm_set1_ps(s) } {}
+
+		static FloatV Load(const float* p) { return _mm_loadu_ps(p); }
+		void Store(float* p) const { _mm_storeu_ps(p, v); }
+		static FloatV LaneIndex() { return _mm_setr_ps(0.f, 1.f, 2.f, 3.f); }
+
+		FloatV operator+(const FloatV& o) const { return _mm_add_ps(v, o.v); }
+		FloatV operator-(const FloatV& o) const { return _mm_sub_ps(v, o.v); }
+		FloatV operator*(const FloatV& o) const { return _mm_mul_ps(v, o.v); }
+		FloatV operator/(const FloatV& o) const { return _mm_div_ps(v, o.v); }
+		FloatV operator&(const FloatV& o) const { return _mm_and_ps(v, o.v); }
+		FloatV operator|(const FloatV& o) const { return _mm_or_ps(v, o.v); }
+		FloatV operator<(const FloatV& o) const { return _mm_cmplt_ps(v, o.v); }
+		FloatV operator<=(const FloatV& o) const { return _mm_cmple_ps(v, o.v); }
+		FloatV operator>(const FloatV& o) const { return _mm_cmpgt_ps(v, o.v); }
+		FloatV operator>=(const FloatV& o) const { return _mm_cmpge_ps(v, o.v); }
+
+		static FloatV Min(const FloatV& a, const FloatV& b) { return _mm_min_ps(a.v, b.v); }
+		static FloatV Max(const FloatV& a, const FloatV& b) { return _mm_max_ps(a.v, b.v); }
+		static FloatV Sqrt(const FloatV& a) { return _mm_sqrt_ps(a.v); }
+		static FloatV Select(const FloatV& mask, const FloatV& a, const FloatV& b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }	// mask ? a : b
+		static int MoveMask(const FloatV& mask) { return _mm_movemask_ps(mask.v); }
+#else
+		static FloatV Load(const float* p) { return *p; }
+		void Store(float* p) const { *p = v; }
+		static FloatV LaneIndex() { return 0.f; }
+
+		FloatV operator+(const FloatV& o) const { return v + o.v; }
+		FloatV operator-(const FloatV& o) const { return v - o.v; }
+		FloatV operator*(const FloatV& o) const { return v * o.v; }
+		FloatV operator/(const FloatV& o) const { return v / o.v; }
+		FloatV operator&(const FloatV& o) const { return FromBits(ToBits(v) & ToBits(o.v)); }
+		FloatV operator|(const FloatV& o) const { return FromBits(ToBits(v) | ToBits(o.v)); }
+		FloatV operator<(const FloatV& o) const { return FromMask(v < o.v); }
+		FloatV operator<=(const FloatV& o) const { return FromMask(v <= o.v); }
+		FloatV operator>(const FloatV& o) const { return FromMask(v > o.v); }
+		FloatV operator>=(const FloatV& o) const { return FromMask(v >= o.v); }
+
+		static FloatV Min(const FloatV& a, const FloatV& b) { return a.v < b.v ? a.v : b.v; }
+		static FloatV Max(const FloatV& a, const FloatV& b) { return a.v > b.v ? a.v : b.v; }
+		static FloatV Sqrt(const FloatV& a) { return std::sqrt(a.v); }
+		static FloatV Select(const FloatV& mask, const FloatV& a, const FloatV& b) { return ToBits(mask.v) ? a : b; }	// mask ? a : b
+		static int MoveMask(const FloatV& mask) { return static_cast<int>(ToBits(mask.v) >> 31); }
+
+	private:
+		static uint32_t ToBits(float f) { uint32_t bits; std::memcpy(&bits, &f, sizeof(bits)); return bits; }
+		static float FromBits(uint32_t bits) { float f; std::memcpy(&f, &bits, sizeof(f)); return f; }
+		static float FromMask(bool b) { return FromBits(b ? 0xFFFFFFFFu : 0u); }
+#endif
+	};
+
+	inline void Normalize(FloatV& x, FloatV& y, FloatV& z)
+	{
+		const FloatV magnitude = FloatV::Sqrt(x * x + y * y + z * z);
+		x = x / magnitude;
+		y = y / magnitude;
+		z = z / magnitude;
+	}
+}
@@ -1,47 +1,123 @@
 
 //includes
+#include <array>
+#include <cfloat>
+#include <cstring>
 #include "Texture.h"
 
 namespace dae {
 
-	Texture::Texture(ID3D11Device* pDevice,  SDL_Surface* pSurface) :
-		m_pSurface{ pSurface },
-		m_pSurfacePixels{ (uint32_t*)pSurface->pixels }
+	// 1 / 255 per byte value, so decoding a channel is a table lookup instead of a divide
+	static const std::array<float, 256> BYTE_TO_FLOAT = []()
+		{
+			std::array<float, 256> table{};
+			for (int idx{}; idx < 256; ++idx)
+				table[idx] = idx / 255.f;
+			return table;
+		}();
+
+	static bool IsPowerOfTwo(int value)
+	{
+		return value > 0 && (value & (value - 1)) == 0;
+	}
+
+	// floor() for values in int range, without the libm call
+	static int FastFloor(float value)
+	{
+		const int truncated = static_cast<int>(value);
+		return truncated - (value < static_cast<float>(truncated));
+	}
+
+	// floor(log2()) of a positive normal float
+	static int FloatExponent(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return static_cast<int>((bits >> 23) & 0xFF) - 127;
+	}
+
+	// log2() from the exponent bits + a quadratic fit of the mantissa (error < 0.005), plenty for mip selection
+	static float FastLog2(float value)
+	{
+		const int exponent = FloatExponent(value);
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		bits = (bits & 0x007FFFFF) | 0x3F800000;	// mantissa in [1, 2)
+		float mantissa;
+		std::memcpy(&mantissa, &bits, sizeof(mantissa));
+		return exponent + (-0.34484843f * mantissa + 2.02466578f) * mantissa - 0.67487759f;
+	}
+
+	Texture::Texture(SDL_Surface* pSurface, TexelFormat texelFormat, TexelLayout texelLayout) :
+		m_pSurface{ pSurface }
 	{
+		ConvertTexels(texelFormat);
+		GenerateMipChain();
+		SetTexelLayout(texelLayout);
+	}
+
+	Texture::~Texture()
+	{
+#if ENABLE_DIRECTX
+		if (m_pSRV)
+			m_pSRV->Release();
+
+		if (m_pResource)
+			m_pResource->Release();
+#endif
+
+		if (m_pSurface) {
+			SDL_FreeSurface(m_pSurface);
+			m_pSurface = nullptr;
+		}
+	}
+
+
+
+
+	Texture* Texture::LoadFromFile(const std::string& path, TexelFormat texelFormat, TexelLayout texelLayout)
+	{
+		//Load SDL_Surface using IMG_LOAD
+		auto SDL_Surf = IMG_Load(path.c_str());
+		Texture* pTex = new Texture( SDL_Surf, texelFormat, texelLayout );
+
+		return pTex;
+	}
+
+
+#if ENABLE_DIRECTX
+	bool Texture::CreateShaderResource(ID3D11Device* pDevice)
+	{
+		SDL_Surface* pSurface = m_pSurface;
+		if (!pSurface)
+			return false;
 
 		DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
 		D3D11_TEXTURE2D_DESC desc{};
 		desc.Width = pSurface->w;
 		desc.Height = pSurface->h;
-		desc.MipLevels = 1;
+		desc.MipLevels = 0;		// full chain, generated on the GPU from level 0
 		desc.ArraySize = 1;
 		desc.Format = format;
 		desc.SampleDesc.Count = 1;
 		desc.SampleDesc.Quality = 0;
 		desc.Usage = D3D11_USAGE_DEFAULT;
-		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;	// GenerateMips needs a render target
 		desc.CPUAccessFlags = 0;
-		desc.MiscFlags = 0;
+		desc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
 
-		D3D11_SUBRESOURCE_DATA initData;
-		initData.pSysMem = pSurface->pixels;
-		initData.SysMemPitch = static_cast<UINT>(pSurface->pitch);
-		initData.SysMemSlicePitch = static_cast<UINT>(pSurface->h * pSurface->pitch);
-
-		HRESULT hr = pDevice->CreateTexture2D(&desc, &initData, &m_pResource);
+		HRESULT hr = pDevice->CreateTexture2D(&desc, nullptr, &m_pResource);
 		if (FAILED(hr) || m_pResource == nullptr) // Check for failure or null resource
 		{
 			std::cerr << "Failed to create texture2D. HRESULT: " << hr << std::endl;
-			SDL_FreeSurface(pSurface); // Free the SDL_Surface since the constructor failed
-			pSurface = nullptr;
-			return; // Early return on failure
+			return false; // the software copy stays usable
 		}
 
 
 		D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc{};
 		SRVDesc.Format = format;
 		SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-		SRVDesc.Texture2D.MipLevels = 1;
+		SRVDesc.Texture2D.MipLevels = static_cast<UINT>(-1);	// every level
 
 		hr = pDevice->CreateShaderResourceView(m_pResource, &SRVDesc, &m_pSRV);
 		if (FAILED(hr) || m_pSRV == nullptr) // Check for failure or null SRV
@@ -49,75 +125,502 @@ namespace dae {
 			std::cerr << "Failed to create shader resource view. HRESULT: " << hr << std::endl;
 			m_pResource->Release(); // Clean up the texture resource if the SRV creation fails
 			m_pResource = nullptr;
+			return false;
+		}
+
+		// Upload level 0, the GPU filters the rest of the chain
+		ID3D11DeviceContext* pDeviceContext = nullptr;
+		pDevice->GetImmediateContext(&pDeviceContext);
+		pDeviceContext->UpdateSubresource(m_pResource, 0, nullptr, pSurface->pixels, static_cast<UINT>(pSurface->pitch), 0);
+		pDeviceContext->GenerateMips(m_pSRV);
+		pDeviceContext->Release();
+		return true;
+	}
 
-			SDL_FreeSurface(pSurface);
-			pSurface = nullptr;
-			return; // Early return on failure
+	ID3D11ShaderResourceView* Texture::GetSRV()
+	{
+		return m_pSRV;
+	}
+#endif
+
+	// Decodes the surface once into a fixed layout, so sampling never goes through SDL_PixelFormat
+	void Texture::ConvertTexels(TexelFormat texelFormat)
+	{
+		if (!m_pSurface)
+		{
+			std::cerr << "Surface was not valid!\n";
+			return;
+		}
+
+		m_TexelFormat = texelFormat;
+
+		MipLevel baseLevel{};
+		baseLevel.width = m_pSurface->w;
+		baseLevel.height = m_pSurface->h;
+		m_MipLevels.push_back(baseLevel);
+
+		const size_t texelCount = static_cast<size_t>(baseLevel.width) * baseLevel.height;
+		if (texelFormat == TexelFormat::RGBA8)
+			m_Texels.resize(texelCount);
+		else
+			m_LinearTexels.resize(texelCount);
+
+		const SDL_PixelFormat* formatPtr = m_pSurface->format;
+		for (int y{}; y < baseLevel.height; ++y)
+		{
+			const uint32_t* pRow = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(m_pSurface->pixels) + y * m_pSurface->pitch);
+			for (int x{}; x < baseLevel.width; ++x)
+			{
+				Uint8 R, G, B, A;
+				SDL_GetRGBA(pRow[x], formatPtr, &R, &G, &B, &A);
+
+				const size_t texelIdx = static_cast<size_t>(x) + static_cast<size_t>(y) * baseLevel.width;
+				if (texelFormat == TexelFormat::RGBA8)
+					m_Texels[texelIdx] = R | (G << 8) | (B << 16) | (static_cast<uint32_t>(A) << 24);
+				else
+					m_LinearTexels[texelIdx] = BYTE_TO_FLOAT[R];
+			}
 		}
 	}
 
-	Texture::~Texture()
+	static float AverageTexels(float a, float b, float c, float d)
 	{
-		if (m_pSRV)
-			m_pSRV->Release();
+		return (a + b + c + d) * 0.25f;
+	}
 
-		if (m_pResource)
-			m_pResource->Release();
+	// Per 8 bit channel
+	template<typename Texel>
+	static Texel AverageTexels(Texel a, Texel b, Texel c, Texel d)
+	{
+		Texel average{};
+		for (int shift{}; shift < static_cast<int>(sizeof(Texel) * 8); shift += 8)
+		{
+			Texel channelSum{ 2 };	// round to nearest
+			for (const Texel texel : { a, b, c, d })
+				channelSum += (texel >> shift) & 0xFF;
+			average |= (channelSum / 4) << shift;
+		}
+		return average;
+	}
 
-		if (m_pSurface) {
-			SDL_FreeSurface(m_pSurface);
-			m_pSurface = nullptr;
+	// Box filters one level from the previous one (odd sizes repeat their last row/column), linear layout
+	template<typename Texel>
+	static void FilterLevel(std::vector<Texel>& texels, size_t sourceOffset, int sourceWidth, int sourceHeight, size_t offset, int width, int height)
+	{
+		texels.resize(offset + static_cast<size_t>(width) * height);
+		for (int y{}; y < height; ++y)
+		{
+			const size_t sourceRow0 = sourceOffset + static_cast<size_t>(std::min(2 * y, sourceHeight - 1)) * sourceWidth;
+			const size_t sourceRow1 = sourceOffset + static_cast<size_t>(std::min(2 * y + 1, sourceHeight - 1)) * sourceWidth;
+			for (int x{}; x < width; ++x)
+			{
+				const size_t x0 = static_cast<size_t>(std::min(2 * x, sourceWidth - 1));
+				const size_t x1 = static_cast<size_t>(std::min(2 * x + 1, sourceWidth - 1));
+				texels[offset + x + static_cast<size_t>(y) * width] = AverageTexels(texels[sourceRow0 + x0], texels[sourceRow0 + x1], texels[sourceRow1 + x0], texels[sourceRow1 + x1]);
+			}
 		}
 	}
 
+	// Every level down to 1x1, runs before the texels get their final layout
+	void Texture::GenerateMipChain()
+	{
+		if (m_MipLevels.empty())
+			return;
+
+		while (m_MipLevels.back().width > 1 || m_MipLevels.back().height > 1)
+		{
+			const MipLevel source = m_MipLevels.back();
+
+			MipLevel level{};
+			level.offset = source.offset + static_cast<size_t>(source.width) * source.height;
+			level.width = std::max(source.width / 2, 1);
+			level.height = std::max(source.height / 2, 1);
+			m_MipLevels.push_back(level);
+
+			switch (m_TexelFormat)
+			{
+			case TexelFormat::RGBA8:
+				FilterLevel(m_Texels, source.offset, source.width, source.height, level.offset, level.width, level.height);
+				break;
+			case TexelFormat::R32F:
+				FilterLevel(m_LinearTexels, source.offset, source.width, source.height, level.offset, level.width, level.height);
+				break;
+			case TexelFormat::Material:
+				FilterLevel(m_MaterialTexels, source.offset, source.width, source.height, level.offset, level.width, level.height);
+				break;
+			}
+		}
 
+		for (MipLevel& level : m_MipLevels)
+		{
+			level.isPowerOfTwo = IsPowerOfTwo(level.width) && IsPowerOfTwo(level.height);
+			level.widthMask = static_cast<uint32_t>(level.width - 1);
+			level.heightMask = static_cast<uint32_t>(level.height - 1);
+			level.blocksPerRow = (level.width + TEXEL_BLOCK_SIZE - 1) / TEXEL_BLOCK_SIZE;
+		}
+	}
 
+	// Full resolution texel as RGBA8, whatever the format
+	uint32_t Texture::GetTexelRGBA8(uint32_t X, uint32_t Y) const
+	{
+		const size_t texelIdx = GetTexelOffset(m_MipLevels[0], m_TexelLayout, X, Y);
+		if (m_TexelFormat == TexelFormat::R32F)
+		{
+			const uint32_t value = static_cast<uint32_t>(m_LinearTexels[texelIdx] * 255.f + 0.5f);
+			return value | (value << 8) | (value << 16) | 0xFF000000u;
+		}
+		return m_Texels[texelIdx];
+	}
 
-	Texture* Texture::LoadFromFile(const std::string& path, ID3D11Device* pDevice)
+	// Interleaves the maps the software shader reads into one 64 bit texel:
+	// diffuse RGB, specular, glossiness, normal XYZ (8 bit each)
+	Texture* Texture::CreateMaterial(const Texture* pDiffuseTexture, const Texture* pNormalTexture, const Texture* pSpecularTexture, const Texture* pGlossinessTexture)
 	{
-		//Load SDL_Surface using IMG_LOAD
-		auto SDL_Surf = IMG_Load(path.c_str());
-		Texture* pTex = new Texture( pDevice, SDL_Surf );
+		const Texture* pTextures[4]{ pDiffuseTexture, pNormalTexture, pSpecularTexture, pGlossinessTexture };
+		for (const Texture* pTexture : pTextures)
+		{
+			if (!pTexture || pTexture->m_MipLevels.empty() || pTexture->m_TexelFormat == TexelFormat::Material)
+				return nullptr;
+			if (pTexture->m_MipLevels[0].width != pDiffuseTexture->m_MipLevels[0].width || pTexture->m_MipLevels[0].height != pDiffuseTexture->m_MipLevels[0].height)
+				return nullptr;	// maps of different resolutions keep their own fetches
+		}
 
-		return pTex;
+		Texture* pMaterial = new Texture{};
+		pMaterial->m_TexelFormat = TexelFormat::Material;
+
+		MipLevel baseLevel{};
+		baseLevel.width = pDiffuseTexture->m_MipLevels[0].width;
+		baseLevel.height = pDiffuseTexture->m_MipLevels[0].height;
+		pMaterial->m_MipLevels.push_back(baseLevel);
+		pMaterial->m_MaterialTexels.resize(static_cast<size_t>(baseLevel.width) * baseLevel.height);
+
+		for (uint32_t Y{}; Y < static_cast<uint32_t>(baseLevel.height); ++Y)
+		{
+			for (uint32_t X{}; X < static_cast<uint32_t>(baseLevel.width); ++X)
+			{
+				const uint64_t diffuse = pDiffuseTexture->GetTexelRGBA8(X, Y) & 0xFFFFFF;
+				const uint64_t specular = pSpecularTexture->GetTexelRGBA8(X, Y) & 0xFF;
+				const uint64_t glossiness = pGlossinessTexture->GetTexelRGBA8(X, Y) & 0xFF;
+				const uint64_t normal = pNormalTexture->GetTexelRGBA8(X, Y) & 0xFFFFFF;
+				pMaterial->m_MaterialTexels[X + static_cast<size_t>(Y) * baseLevel.width] = diffuse | (specular << 24) | (glossiness << 32) | (normal << 40);
+			}
+		}
+
+		pMaterial->GenerateMipChain();
+		pMaterial->SetTexelLayout(pDiffuseTexture->m_TexelLayout);
+		return pMaterial;
 	}
 
+	// Tiled levels are padded to whole blocks
+	size_t Texture::GetLevelTexelCount(const MipLevel& level, TexelLayout texelLayout)
+	{
+		if (texelLayout == TexelLayout::Linear)
+			return static_cast<size_t>(level.width) * level.height;
 
-	ID3D11ShaderResourceView* Texture::GetSRV()
+		const size_t blockRows = (level.height + TEXEL_BLOCK_SIZE - 1) / TEXEL_BLOCK_SIZE;
+		return static_cast<size_t>(level.blocksPerRow) * blockRows * (TEXEL_BLOCK_SIZE * TEXEL_BLOCK_SIZE);
+	}
+
+	size_t Texture::GetTexelOffset(const MipLevel& level, TexelLayout texelLayout, uint32_t X, uint32_t Y)
 	{
-		return m_pSRV;
+		if (texelLayout == TexelLayout::Linear)
+			return level.offset + X + static_cast<size_t>(Y) * level.width;
+
+		const size_t blockIdx = (Y / TEXEL_BLOCK_SIZE) * static_cast<size_t>(level.blocksPerRow) + X / TEXEL_BLOCK_SIZE;
+		return level.offset + blockIdx * (TEXEL_BLOCK_SIZE * TEXEL_BLOCK_SIZE) + (Y % TEXEL_BLOCK_SIZE) * TEXEL_BLOCK_SIZE + X % TEXEL_BLOCK_SIZE;
 	}
 
-	ColorRGB Texture::Sample(const Vector2& uv) const
+	template<typename Texel>
+	void Texture::ReorderTexels(std::vector<Texel>& texels, const std::vector<MipLevel>& sourceLevels, TexelLayout sourceLayout,
+		const std::vector<MipLevel>& targetLevels, TexelLayout targetLayout)
 	{
-		if (!m_pSurface)
+		if (texels.empty())
+			return;
+
+		std::vector<Texel> reordered(targetLevels.back().offset + GetLevelTexelCount(targetLevels.back(), targetLayout));
+		for (size_t levelIdx{}; levelIdx < targetLevels.size(); ++levelIdx)
 		{
-			std::cerr << "Surface was not valid!\n";
-			return { 0.f, 0.f, 0.f }; // Return a default color
+			const MipLevel& sourceLevel = sourceLevels[levelIdx];
+			const MipLevel& targetLevel = targetLevels[levelIdx];
+			for (uint32_t Y{}; Y < static_cast<uint32_t>(targetLevel.height); ++Y)
+				for (uint32_t X{}; X < static_cast<uint32_t>(targetLevel.width); ++X)
+					reordered[GetTexelOffset(targetLevel, targetLayout, X, Y)] = texels[GetTexelOffset(sourceLevel, sourceLayout, X, Y)];
+		}
+		texels = std::move(reordered);
+	}
+
+	void Texture::SetTexelLayout(TexelLayout texelLayout)
+	{
+		if (texelLayout == m_TexelLayout || m_MipLevels.empty())
+			return;
+
+		std::vector<MipLevel> levels = m_MipLevels;
+		size_t offset{};
+		for (MipLevel& level : levels)
+		{
+			level.offset = offset;
+			offset += GetLevelTexelCount(level, texelLayout);
+		}
+
+		ReorderTexels(m_Texels, m_MipLevels, m_TexelLayout, levels, texelLayout);
+		ReorderTexels(m_LinearTexels, m_MipLevels, m_TexelLayout, levels, texelLayout);
+		ReorderTexels(m_MaterialTexels, m_MipLevels, m_TexelLayout, levels, texelLayout);
+		m_MipLevels = std::move(levels);
+		m_TexelLayout = texelLayout;
+	}
+
+	template<>
+	ColorRGB Texture::Decode<ColorRGB>(size_t texelIdx) const
+	{
+		if (m_TexelFormat == TexelFormat::R32F)
+		{
+			const float value = m_LinearTexels[texelIdx];
+			return { value, value, value };
+		}
+
+		const uint32_t texel = m_Texels[texelIdx];
+		return { BYTE_TO_FLOAT[texel & 0xFF], BYTE_TO_FLOAT[(texel >> 8) & 0xFF], BYTE_TO_FLOAT[(texel >> 16) & 0xFF] };
+	}
+
+	template<>
+	float Texture::Decode<float>(size_t texelIdx) const
+	{
+		if (m_TexelFormat == TexelFormat::R32F)
+			return m_LinearTexels[texelIdx];
+
+		return BYTE_TO_FLOAT[m_Texels[texelIdx] & 0xFF];
+	}
+
+	template<>
+	ColorAlphaSample Texture::Decode<ColorAlphaSample>(size_t texelIdx) const
+	{
+		if (m_TexelFormat == TexelFormat::R32F)
+		{
+			const float value = m_LinearTexels[texelIdx];
+			return { { value, value, value }, 1.f };
+		}
+
+		const uint32_t texel = m_Texels[texelIdx];
+		return { { BYTE_TO_FLOAT[texel & 0xFF], BYTE_TO_FLOAT[(texel >> 8) & 0xFF], BYTE_TO_FLOAT[(texel >> 16) & 0xFF] }, BYTE_TO_FLOAT[texel >> 24] };
+	}
+
+	template<>
+	MaterialSample Texture::Decode<MaterialSample>(size_t texelIdx) const
+	{
+		const uint64_t texel = m_MaterialTexels[texelIdx];
+		const auto channel = [texel](int byteIdx) { return BYTE_TO_FLOAT[(texel >> (byteIdx * 8)) & 0xFF]; };
+
+		MaterialSample sample{};
+		sample.diffuse = { channel(0), channel(1), channel(2) };
+		sample.specular = channel(3);
+		sample.glossiness = channel(4);
+		sample.normal = { channel(5), channel(6), channel(7) };
+		return sample;
+	}
+
+	// UVs wrap for tiling
+	static uint32_t WrapCoordinate(int coordinate, int size, uint32_t mask, bool isPowerOfTwo)
+	{
+		if (isPowerOfTwo)
+			return static_cast<uint32_t>(coordinate) & mask;
+
+		const int wrapped = coordinate % size;
+		return static_cast<uint32_t>(wrapped < 0 ? wrapped + size : wrapped);
+	}
+
+	template<typename Value>
+	static Value LerpValue(const Value& a, const Value& b, float factor)
+	{
+		return a + (b - a) * factor;
+	}
+
+	// Nearest texel
+	template<typename Value>
+	Value Texture::SamplePoint(const MipLevel& level, float u, float v) const
+	{
+		const uint32_t X = WrapCoordinate(FastFloor(u * level.width), level.width, level.widthMask, level.isPowerOfTwo);
+		const uint32_t Y = WrapCoordinate(FastFloor(v * level.height), level.height, level.heightMask, level.isPowerOfTwo);
+		return Decode<Value>(GetTexelOffset(level, m_TexelLayout, X, Y));
+	}
+
+	// 2x2 texels around the sample, texel centers at half integers (same convention as D3D)
+	template<typename Value>
+	Value Texture::SampleBilinear(const MipLevel& level, float u, float v) const
+	{
+		const float x = u * level.width - 0.5f;
+		const float y = v * level.height - 0.5f;
+		const int x0 = FastFloor(x);
+		const int y0 = FastFloor(y);
+		const float weightX = x - x0;
+		const float weightY = y - y0;
+
+		const uint32_t X0 = WrapCoordinate(x0, level.width, level.widthMask, level.isPowerOfTwo);
+		const uint32_t X1 = WrapCoordinate(x0 + 1, level.width, level.widthMask, level.isPowerOfTwo);
+		const uint32_t Y0 = WrapCoordinate(y0, level.height, level.heightMask, level.isPowerOfTwo);
+		const uint32_t Y1 = WrapCoordinate(y0 + 1, level.height, level.heightMask, level.isPowerOfTwo);
+
+		const Value top = LerpValue(Decode<Value>(GetTexelOffset(level, m_TexelLayout, X0, Y0)), Decode<Value>(GetTexelOffset(level, m_TexelLayout, X1, Y0)), weightX);
+		const Value bottom = LerpValue(Decode<Value>(GetTexelOffset(level, m_TexelLayout, X0, Y1)), Decode<Value>(GetTexelOffset(level, m_TexelLayout, X1, Y1)), weightX);
+		return LerpValue(top, bottom, weightY);
+	}
+
+	// Point: nearest level + nearest texel, linear: trilinear (bilinear when magnified)
+	template<typename Value>
+	Value Texture::SampleLevel(float lod, float u, float v, bool isLinear) const
+	{
+		const int lastLevel = static_cast<int>(m_MipLevels.size()) - 1;
+		if (!isLinear)
+		{
+			const int levelIdx = std::clamp(static_cast<int>(lod + 0.5f), 0, lastLevel);
+			return SamplePoint<Value>(m_MipLevels[levelIdx], u, v);
 		}
 
-		// --- Wrap UVs for tiling ---
-		float u = uv.x - std::floor(uv.x);
-		float v = uv.y - std::floor(uv.y);
+		if (lod <= 0.f)
+			return SampleBilinear<Value>(m_MipLevels[0], u, v);
+		if (lod >= static_cast<float>(lastLevel))
+			return SampleBilinear<Value>(m_MipLevels[lastLevel], u, v);
+
+		const int levelIdx = static_cast<int>(lod);
+		return LerpValue(SampleBilinear<Value>(m_MipLevels[levelIdx], u, v), SampleBilinear<Value>(m_MipLevels[levelIdx + 1], u, v), lod - levelIdx);
+	}
+
+	template<typename Value>
+	Value Texture::SampleFiltered(float u, float v, const UVGradient& gradient, FilteringMethod filteringMethod) const
+	{
+		// Footprint of the pixel in texels of the full resolution level
+		const MipLevel& baseLevel = m_MipLevels[0];
+		const float dxU = gradient.dudx * baseLevel.width;
+		const float dxV = gradient.dvdx * baseLevel.height;
+		const float dyU = gradient.dudy * baseLevel.width;
+		const float dyV = gradient.dvdy * baseLevel.height;
+		const float lengthSqrX = std::max(dxU * dxU + dxV * dxV, FLT_MIN);
+		const float lengthSqrY = std::max(dyU * dyU + dyV * dyV, FLT_MIN);
 
-		int X = static_cast<int>(u * m_pSurface->w);
-		int Y = static_cast<int>(v * m_pSurface->h);
+		if (filteringMethod == FilteringMethod::Point)
+		{
+			// round(log2 of the longest axis) = floor(log2(2 * lengthSqr) / 2), straight from the exponent bits
+			const int levelIdx = std::clamp(FloatExponent(2.f * std::max(lengthSqrX, lengthSqrY)) >> 1, 0, static_cast<int>(m_MipLevels.size()) - 1);
+			return SamplePoint<Value>(m_MipLevels[levelIdx], u, v);
+		}
+		if (filteringMethod == FilteringMethod::Linear)
+		{
+			const float lod = 0.5f * FastLog2(std::max(lengthSqrX, lengthSqrY));	// log2 of the longest axis
+			return SampleLevel<Value>(lod, u, v, true);
+		}
 
-		// Clamp X and Y to ensure they are within bounds
-		X = Clamp(X, 0, m_pSurface->w - 1);
-		Y = Clamp(Y, 0, m_pSurface->h - 1);
+		// Anisotropic: trilinear taps spread along the major axis, the level follows the minor axis
+		const bool isMajorX = lengthSqrX >= lengthSqrY;
+		const float majorLength = std::sqrt(isMajorX ? lengthSqrX : lengthSqrY);
+		const float minorLength = std::sqrt(isMajorX ? lengthSqrY : lengthSqrX);
+		// Clamped as a float before the cast: a collapsed minor axis makes the ratio overflow an int (and NaN ends up at the maximum)
+		const float anisotropy = std::min(static_cast<float>(MAX_ANISOTROPY), majorLength / minorLength);
+		const int sampleCount = std::max(static_cast<int>(std::ceil(anisotropy)), 1);
+		const float lod = FastLog2(majorLength / sampleCount);
+		if (sampleCount == 1)
+			return SampleLevel<Value>(lod, u, v, true);
 
-		// Fetch pixel data
-		Uint8 R, G, B;
-		SDL_PixelFormat* formatPtr = m_pSurface->format;
-		if (!m_pSurfacePixels) 
+		const float majorU = isMajorX ? gradient.dudx : gradient.dudy;
+		const float majorV = isMajorX ? gradient.dvdx : gradient.dvdy;
+		Value sum{};
+		for (int sampleIdx{}; sampleIdx < sampleCount; ++sampleIdx)
 		{
-			std::cerr << "SurfacePixels was not valid!\n";
+			const float offset = (sampleIdx + 0.5f) / sampleCount - 0.5f;
+			sum += SampleLevel<Value>(lod, u + majorU * offset, v + majorV * offset, true);
+		}
+		return sum * (1.f / sampleCount);
+	}
+
+	ColorRGB Texture::Sample(const Vector2& uv) const
+	{
+		if (m_MipLevels.empty())
 			return { 0.f, 0.f, 0.f }; // Return a default color
+
+		return SamplePoint<ColorRGB>(m_MipLevels[0], uv.x, uv.y);
+	}
+
+	ColorRGB Texture::Sample(const Vector2& uv, const UVGradient& gradient, FilteringMethod filteringMethod) const
+	{
+		if (m_MipLevels.empty())
+			return { 0.f, 0.f, 0.f }; // Return a default color
+
+		return SampleFiltered<ColorRGB>(uv.x, uv.y, gradient, filteringMethod);
+	}
+
+	float Texture::SampleRed(const Vector2& uv, const UVGradient& gradient, FilteringMethod filteringMethod) const
+	{
+		if (m_MipLevels.empty())
+			return 0.f;
+
+		return SampleFiltered<float>(uv.x, uv.y, gradient, filteringMethod);
+	}
+
+	ColorAlphaSample Texture::SampleColorAlpha(const Vector2& uv, const UVGradient& gradient, FilteringMethod filteringMethod) const
+	{
+		if (m_MipLevels.empty())
+			return {};
+
+		return SampleFiltered<ColorAlphaSample>(uv.x, uv.y, gradient, filteringMethod);
+	}
+
+	MaterialSample Texture::SampleMaterial(const Vector2& uv, const UVGradient& gradient, FilteringMethod filteringMethod) const
+	{
+		if (m_MipLevels.empty())
+			return {};
+
+		return SampleFiltered<MaterialSample>(uv.x, uv.y, gradient, filteringMethod);
+	}
+
+	// No work is shared between the lanes (the gradients, and so the levels and taps, differ per lane)
+	template<typename Value, int Count>
+	void Texture::SampleBatch(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, Value* pValues) const
+	{
+		if (m_MipLevels.empty())
+		{
+			std::fill_n(pValues, Count, Value{});
+			return;
 		}
-		SDL_GetRGB(m_pSurfacePixels[X + (Y * m_pSurface->w)], formatPtr, &R, &G, &B);
 
-		// Normalize the colors
-		return { R / 255.f,G / 255.f,B / 255.f };
+		for (int lane{}; lane < Count; ++lane)
+			pValues[lane] = SampleFiltered<Value>(pU[lane], pV[lane], pGradients[lane], filteringMethod);
+	}
+
+	void Texture::Sample4(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, ColorRGB* pColors) const
+	{
+		SampleBatch<ColorRGB, 4>(pU, pV, pGradients, filteringMethod, pColors);
+	}
+
+	void Texture::Sample8(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, ColorRGB* pColors) const
+	{
+		SampleBatch<ColorRGB, 8>(pU, pV, pGradients, filteringMethod, pColors);
+	}
+
+	void Texture::SampleRed4(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, float* pValues) const
+	{
+		SampleBatch<float, 4>(pU, pV, pGradients, filteringMethod, pValues);
+	}
+
+	void Texture::SampleRed8(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, float* pValues) const
+	{
+		SampleBatch<float, 8>(pU, pV, pGradients, filteringMethod, pValues);
+	}
+
+	void Texture::SampleColorAlpha4(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, ColorAlphaSample* pSamples) const
+	{
+		SampleBatch<ColorAlphaSample, 4>(pU, pV, pGradients, filteringMethod, pSamples);
+	}
+
+	void Texture::SampleColorAlpha8(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, ColorAlphaSample* pSamples) const
+	{
+		SampleBatch<ColorAlphaSample, 8>(pU, pV, pGradients, filteringMethod, pSamples);
+	}
+
+	void Texture::SampleMaterial4(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, MaterialSample* pSamples) const
+	{
+		SampleBatch<MaterialSample, 4>(pU, pV, pGradients, filteringMethod, pSamples);
+	}
+
+	void Texture::SampleMaterial8(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, MaterialSample* pSamples) const
+	{
+		SampleBatch<MaterialSample, 8>(pU, pV, pGradients, filteringMethod, pSamples);
 	}
-}
\ No newline at end of file
+}
@@ -4,6 +4,66 @@
 #include "pch.h"
 
 namespace dae {
+	enum class FilteringMethod
+	{
+		Point = 0,
+		Linear = 1,
+		Anisotropic = 2
+	};
+
+	// Software texel layout, converted once at load time
+	enum class TexelFormat
+	{
+		RGBA8,	// 4 channels, 8 bit each (R in the lowest byte)
+		R32F,	// single linear float channel (greyscale maps that are only read through .r)
+		Material	// packed material, see Texture::CreateMaterial
+	};
+
+	// Software texel order in memory
+	enum class TexelLayout
+	{
+		Linear,	// row-major
+		Tiled	// 4x4 texel blocks (one cache line each), row-major blocks: fetch locality no longer depends on the uv direction
+	};
+
+	constexpr int TEXEL_BLOCK_SIZE{ 4 };
+
+	// Screen space derivatives of the texture coordinates, they select the mip level (and the anisotropic footprint)
+	struct UVGradient
+	{
+		float dudx{}, dvdx{};
+		float dudy{}, dvdy{};
+	};
+
+	// Everything the software shader reads from the material maps, one fetch from a packed material texture
+	struct MaterialSample
+	{
+		ColorRGB diffuse{};
+		ColorRGB normal{};		// tangent space, still in [0, 1]
+		float specular{};
+		float glossiness{};
+
+		MaterialSample operator+(const MaterialSample& s) const { return { diffuse + s.diffuse, normal + s.normal, specular + s.specular, glossiness + s.glossiness }; };
+		MaterialSample operator-(const MaterialSample& s) const { return { diffuse - s.diffuse, normal - s.normal, specular - s.specular, glossiness - s.glossiness }; };
+		MaterialSample operator*(float f) const { return { diffuse * f, normal * f, specular * f, glossiness * f }; };
+		MaterialSample& operator+=(const MaterialSample& s) { return *this = *this + s; };
+	};
+
+	// Color + coverage of a partial coverage (alpha blended) texture
+	struct ColorAlphaSample
+	{
+		ColorRGB color{};
+		float alpha{};
+
+		ColorAlphaSample operator+(const ColorAlphaSample& s) const { return { color + s.color, alpha + s.alpha }; };
+		ColorAlphaSample operator-(const ColorAlphaSample& s) const { return { color - s.color, alpha - s.alpha }; };
+		ColorAlphaSample operator*(float f) const { return { color * f, alpha * f }; };
+		ColorAlphaSample& operator+=(const ColorAlphaSample& s) { return *this = *this + s; };
+	};
+
+	// Same limit as the default D3D11 sampler state
+	constexpr int MAX_ANISOTROPY{ 16 };
+
 	class Texture
 	{
 	public:
@@ -22,20 +82,94 @@ namespace dae {
 		// Member Functions
 		// ------
 
-		static Texture* LoadFromFile(const std::string& path, ID3D11Device* pDevice);
-		ColorRGB Sample(const Vector2& uv) const;
+		static Texture* LoadFromFile(const std::string& path, TexelFormat texelFormat = TexelFormat::RGBA8, TexelLayout texelLayout = TexelLayout::Tiled);
+		static Texture* CreateMaterial(const Texture* pDiffuseTexture, const Texture* pNormalTexture, const Texture* pSpecularTexture, const Texture* pGlossinessTexture);	// software only, nullptr when the maps can't be packed
+		ColorRGB Sample(const Vector2& uv) const;	// nearest texel of the full resolution level
+		ColorRGB Sample(const Vector2& uv, const UVGradient& gradient, FilteringMethod filteringMethod) const;
+		float SampleRed(const Vector2& uv, const UVGradient& gradient, FilteringMethod filteringMethod) const;
+
+		// Batched (one call per quad), one uv + gradient per lane. These are plain per-lane loops over the scalar filter:
+		// each lane still picks its own level and taps, they only keep one call site per quad for every lane count
+		void Sample4(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, ColorRGB* pColors) const;
+		void Sample8(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, ColorRGB* pColors) const;
+		void SampleRed4(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, float* pValues) const;
+		void SampleRed8(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, float* pValues) const;
+
+		// Color + alpha channel (alpha is 1 for single channel textures)
+		ColorAlphaSample SampleColorAlpha(const Vector2& uv, const UVGradient& gradient, FilteringMethod filteringMethod) const;
+		void SampleColorAlpha4(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, ColorAlphaSample* pSamples) const;
+		void SampleColorAlpha8(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, ColorAlphaSample* pSamples) const;
+
+		// Packed material textures only
+		MaterialSample SampleMaterial(const Vector2& uv, const UVGradient& gradient, FilteringMethod filteringMethod) const;
+		void SampleMaterial4(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, MaterialSample* pSamples) const;
+		void SampleMaterial8(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, MaterialSample* pSamples) const;
+
+		void SetTexelLayout(TexelLayout texelLayout);	// reorders every mip level
+
+#if ENABLE_DIRECTX
+		bool CreateShaderResource(ID3D11Device* pDevice);	// hardware copy of the surface, with a GPU generated mip chain
+#endif
 
 		// Getter func
+#if ENABLE_DIRECTX
 		ID3D11ShaderResourceView* GetSRV();
+#endif
+		TexelLayout GetTexelLayout() const { return m_TexelLayout; };
+		int GetMipLevelCount() const { return static_cast<int>(m_MipLevels.size()); };
 
 	private:
-		Texture(ID3D11Device* pDevice, SDL_Surface* pSurface);
+		Texture() = default;	// built from other textures, no surface
+		Texture(SDL_Surface* pSurface, TexelFormat texelFormat, TexelLayout texelLayout);
+
+		// One level of the mip chain, all levels share one texel array
+		struct MipLevel
+		{
+			size_t offset{};
+			int width{};
+			int height{};
+			bool isPowerOfTwo{};		// wrap by masking
+			uint32_t widthMask{};
+			uint32_t heightMask{};
+			int blocksPerRow{};			// tiled layout
+		};
 
+		static size_t GetLevelTexelCount(const MipLevel& level, TexelLayout texelLayout);
+		static size_t GetTexelOffset(const MipLevel& level, TexelLayout texelLayout, uint32_t X, uint32_t Y);
+		template<typename Texel>
+		static void ReorderTexels(std::vector<Texel>& texels, const std::vector<MipLevel>& sourceLevels, TexelLayout sourceLayout,
+			const std::vector<MipLevel>& targetLevels, TexelLayout targetLayout);
+
+		void ConvertTexels(TexelFormat texelFormat);
+		void GenerateMipChain();
+		uint32_t GetTexelRGBA8(uint32_t X, uint32_t Y) const;
+
+		template<typename Value>
+		Value Decode(size_t texelIdx) const;
+		template<typename Value>
+		Value SamplePoint(const MipLevel& level, float u, float v) const;
+		template<typename Value>
+		Value SampleBilinear(const MipLevel& level, float u, float v) const;
+		template<typename Value>
+		Value SampleLevel(float lod, float u, float v, bool isLinear) const;
+		template<typename Value>
+		Value SampleFiltered(float u, float v, const UVGradient& gradient, FilteringMethod filteringMethod) const;
+		template<typename Value, int Count>
+		void SampleBatch(const float* pU, const float* pV, const UVGradient* pGradients, FilteringMethod filteringMethod, Value* pValues) const;
+
+#if ENABLE_DIRECTX
 		ID3D11Texture2D* m_pResource = nullptr;
 		ID3D11ShaderResourceView* m_pSRV = nullptr;
+#endif
 
 		//software
 		SDL_Surface* m_pSurface=nullptr ;
-		uint32_t* m_pSurfacePixels=nullptr ;
+
+		TexelFormat m_TexelFormat{ TexelFormat::RGBA8 };
+		TexelLayout m_TexelLayout{ TexelLayout::Linear };
+		std::vector<uint32_t> m_Texels{};		// RGBA8, every mip level
+		std::vector<float> m_LinearTexels{};	// R32F, every mip level
+		std::vector<uint64_t> m_MaterialTexels{};	// Material, every mip level
+		std::vector<MipLevel> m_MipLevels{};
 	};
-}
\ No newline at end of file
+}
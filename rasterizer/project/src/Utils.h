@@ -1,18 +1,171 @@
 #pragma once
-#include <fstream>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
 #include "Math.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "ParallelObjParser.h"
 
 namespace dae
 {
 	namespace Utils
 	{
-		//Just parses vertices and indices
-#pragma warning(push)
-#pragma warning(disable : 4505) //Warning unreferenced local function
-		static bool ParseOBJ(const std::string& filename, std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
+		// One face corner of an OBJ: 0-based position / uv / normal indices (NO_OBJ_INDEX when the corner has none)
+		constexpr uint32_t NO_OBJ_INDEX{ UINT32_MAX };
+		struct ObjCorner
 		{
-			std::ifstream file(filename);
-			if (!file)
+			uint32_t position{ NO_OBJ_INDEX };
+			uint32_t uv{ NO_OBJ_INDEX };
+			uint32_t normal{ NO_OBJ_INDEX };
+
+			bool operator==(const ObjCorner& other) const { return position == other.position && uv == other.uv && normal == other.normal; };
+		};
+		struct ObjCornerHash
+		{
+			size_t operator()(const ObjCorner& corner) const
+			{
+				uint64_t hash = corner.position * 0x9E3779B97F4A7C15ull;
+				hash ^= (corner.uv + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full + (hash << 6) + (hash >> 2);
+				hash ^= (corner.normal + 0x165667B19E3779F9ull) * 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+				return static_cast<size_t>(hash);
+			}
+		};
+
+		// Text helpers of the OBJ parser, they never read past pEnd
+		inline const char* SkipSpaces(const char* pCursor, const char* pEnd)
+		{
+			while (pCursor < pEnd && (*pCursor == ' ' || *pCursor == '\t' || *pCursor == '\r'))
+				++pCursor;
+			return pCursor;
+		}
+		inline const char* SkipLine(const char* pCursor, const char* pEnd)
+		{
+			const char* pNewLine = static_cast<const char*>(std::memchr(pCursor, '\n', pEnd - pCursor));
+			return pNewLine ? pNewLine + 1 : pEnd;
+		}
+		inline bool ParseFloats(const char*& pCursor, const char* pEnd, float* pValues, int count)
+		{
+			for (int idx{}; idx < count; ++idx)
+			{
+				pCursor = SkipSpaces(pCursor, pEnd);
+				const std::from_chars_result result = std::from_chars(pCursor, pEnd, pValues[idx]);
+				if (result.ec != std::errc{})
+					return false;
+				pCursor = result.ptr;
+			}
+			return true;
+		}
+		// 1-based or negative (relative to the end) OBJ index -> 0-based, NO_OBJ_INDEX when out of range
+		inline uint32_t ResolveObjIndex(int64_t objIndex, size_t count)
+		{
+			const int64_t index = objIndex < 0 ? static_cast<int64_t>(count) + objIndex : objIndex - 1;
+			return index >= 0 && index < static_cast<int64_t>(count) ? static_cast<uint32_t>(index) : NO_OBJ_INDEX;
+		}
+
+		// One face corner as written: "p", "p/t", "p//n" or "p/t/n" (OBJ format uses 1-based arrays, negative = from the end)
+		struct ObjFaceCorner
+		{
+			int64_t objIndices[3]{};
+			bool hasIndex[3]{};
+		};
+		// false at the end of the line
+		inline bool ParseObjFaceCorner(const char*& pCursor, const char* pEnd, ObjFaceCorner& faceCorner)
+		{
+			pCursor = SkipSpaces(pCursor, pEnd);
+			if (pCursor >= pEnd || *pCursor == '\n')
+				return false;
+
+			faceCorner = {};
+			for (int component{}; component < 3; ++component)
+			{
+				const std::from_chars_result result = std::from_chars(pCursor, pEnd, faceCorner.objIndices[component]);
+				faceCorner.hasIndex[component] = result.ec == std::errc{};
+				pCursor = result.ptr;
+				if (pCursor >= pEnd || *pCursor != '/')
+					break;
+				++pCursor;	// read and ignore one element ('/')
+			}
+			return true;
+		}
+		// Against the element counts read so far, false for a broken or unsupported corner (its face gets dropped)
+		inline bool ResolveObjFaceCorner(const ObjFaceCorner& faceCorner, size_t positionCount, size_t uvCount, size_t normalCount, ObjCorner& corner)
+		{
+			corner = {};
+			corner.position = faceCorner.hasIndex[0] ? ResolveObjIndex(faceCorner.objIndices[0], positionCount) : NO_OBJ_INDEX;
+			if (faceCorner.hasIndex[1])
+				corner.uv = ResolveObjIndex(faceCorner.objIndices[1], uvCount);
+			if (faceCorner.hasIndex[2])
+				corner.normal = ResolveObjIndex(faceCorner.objIndices[2], normalCount);
+
+			return corner.position != NO_OBJ_INDEX && (!faceCorner.hasIndex[1] || corner.uv != NO_OBJ_INDEX) && (!faceCorner.hasIndex[2] || corner.normal != NO_OBJ_INDEX);
+		}
+		inline Vertex_In MakeObjVertex(const ObjCorner& corner, const std::vector<Vector3>& positions, const std::vector<Vector2>& UVs, const std::vector<Vector3>& normals)
+		{
+			Vertex_In vertex{};
+			vertex.position = positions[corner.position];
+			if (corner.uv != NO_OBJ_INDEX)
+				vertex.uv = UVs[corner.uv];
+			if (corner.normal != NO_OBJ_INDEX)
+				vertex.normal = normals[corner.normal];
+			return vertex;
+		}
+		// Triangle fan (quads and n-gons are convex in practice)
+		inline void AppendObjFace(const std::vector<uint32_t>& faceVertices, bool flipAxisAndWinding, std::vector<uint32_t>& indices)
+		{
+			for (size_t corner = 1; corner + 1 < faceVertices.size(); ++corner)
+			{
+				indices.push_back(faceVertices[0]);
+				if (flipAxisAndWinding)
+				{
+					indices.push_back(faceVertices[corner + 1]);
+					indices.push_back(faceVertices[corner]);
+				}
+				else
+				{
+					indices.push_back(faceVertices[corner]);
+					indices.push_back(faceVertices[corner + 1]);
+				}
+			}
+		}
+
+		//Cheap Tangent Calculations, false for a degenerate uv mapping (its infinite tangent would spread to every triangle sharing the vertices)
+		inline bool ComputeTriangleTangent(const Vertex_In& vertex0, const Vertex_In& vertex1, const Vertex_In& vertex2, Vector3& tangent)
+		{
+			const Vector3 edge0 = vertex1.position - vertex0.position;
+			const Vector3 edge1 = vertex2.position - vertex0.position;
+			const Vector2 diffX = Vector2(vertex1.uv.x - vertex0.uv.x, vertex2.uv.x - vertex0.uv.x);
+			const Vector2 diffY = Vector2(vertex1.uv.y - vertex0.uv.y, vertex2.uv.y - vertex0.uv.y);
+			const float uvArea = Vector2::Cross(diffX, diffY);
+			if (uvArea == 0.f)
+				return false;
+			float r = 1.f / uvArea;
+
+			tangent = (edge0 * diffY.y - edge1 * diffY.x) * r;
+			return true;
+		}
+		//Create the Tangents (reject) + convert to the left handed system
+		inline void FinalizeObjVertex(Vertex_In& v, bool flipAxisAndWinding)
+		{
+			v.tangent = Vector3::Reject(v.tangent, v.normal).Normalized();
+
+			if (flipAxisAndWinding)
+			{
+				v.position.z *= -1.f;
+				v.normal.z *= -1.f;
+				v.tangent.z *= -1.f;
+			}
+		}
+
+		//Parses vertices and indices: the file is memory-mapped, numbers go through std::from_chars,
+		//faces of any size are fanned into triangles and identical position/uv/normal corners share one vertex
+		inline bool ParseOBJ(const std::string& filename, std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
+		{
+			MappedFile file{};
+			if (!file.Open(filename))
 				return false;
 
 			std::vector<Vector3> positions{};
@@ -22,142 +175,108 @@ namespace dae
 			vertices.clear();
 			indices.clear();
 
-			std::string sCommand;
-			// start a while iteration ending when the end of file is reached (ios::eof)
-			while (!file.eof())
+			std::unordered_map<ObjCorner, uint32_t, ObjCornerHash> cornerToVertex{};
+			std::vector<uint32_t> faceVertices{};
+
+			const char* pCursor = file.GetData();
+			const char* pEnd = pCursor + file.GetSize();
+			for (; pCursor < pEnd; pCursor = SkipLine(pCursor, pEnd))
 			{
-				//read the first word of the string, use the >> operator (istream::operator>>) 
-				file >> sCommand;
-				//use conditional statements to process the different commands	
-				if (sCommand == "#")
-				{
-					// Ignore Comment
-				}
-				else if (sCommand == "v")
+				pCursor = SkipSpaces(pCursor, pEnd);
+				if (pEnd - pCursor < 2)
+					continue;
+
+				const char command = pCursor[0];
+				const char subCommand = pCursor[1];
+				if (command == 'v' && (subCommand == ' ' || subCommand == '\t'))
 				{
 					//Vertex
-					float x, y, z;
-					file >> x >> y >> z;
-
-					positions.emplace_back(x, y, z);
+					float values[3];
+					pCursor += 1;
+					if (ParseFloats(pCursor, pEnd, values, 3))
+						positions.emplace_back(values[0], values[1], values[2]);
 				}
-				else if (sCommand == "vt")
+				else if (command == 'v' && subCommand == 't')
 				{
 					// Vertex TexCoord
-					float u, v;
-					file >> u >> v;
-					UVs.emplace_back(u, 1 - v);
+					float values[2];
+					pCursor += 2;
+					if (ParseFloats(pCursor, pEnd, values, 2))
+						UVs.emplace_back(values[0], 1 - values[1]);
 				}
-				else if (sCommand == "vn")
+				else if (command == 'v' && subCommand == 'n')
 				{
 					// Vertex Normal
-					float x, y, z;
-					file >> x >> y >> z;
-
-					normals.emplace_back(x, y, z);
+					float values[3];
+					pCursor += 2;
+					if (ParseFloats(pCursor, pEnd, values, 3))
+						normals.emplace_back(values[0], values[1], values[2]);
 				}
-				else if (sCommand == "f")
+				else if (command == 'f' && (subCommand == ' ' || subCommand == '\t'))
 				{
-					//if a face is read:
-					//construct the 3 vertices, add them to the vertex array
-					//add three indices to the index array
-					//add the material index as attibute to the attribute array
-					//
-					// Faces or triangles
-					Vertex_In vertex{};
-					size_t iPosition, iTexCoord, iNormal;
-
-					uint32_t tempIndices[3];
-					for (size_t iFace = 0; iFace < 3; iFace++)
+					// Faces
+					faceVertices.clear();
+					bool isValidFace{ true };
+					++pCursor;
+					ObjFaceCorner faceCorner{};
+					while (ParseObjFaceCorner(pCursor, pEnd, faceCorner))
 					{
-						// OBJ format uses 1-based arrays
-						file >> iPosition;
-						vertex.position = positions[iPosition - 1];
-
-						if ('/' == file.peek())//is next in buffer ==  '/' ?
+						ObjCorner corner{};
+						if (!ResolveObjFaceCorner(faceCorner, positions.size(), UVs.size(), normals.size(), corner))
 						{
-							file.ignore();//read and ignore one element ('/')
-
-							if ('/' != file.peek())
-							{
-								// Optional texture coordinate
-								file >> iTexCoord;
-								vertex.uv = UVs[iTexCoord - 1];
-							}
-
-							if ('/' == file.peek())
-							{
-								file.ignore();
-
-								// Optional vertex normal
-								file >> iNormal;
-								vertex.normal = normals[iNormal - 1];
-							}
+							isValidFace = false;	// broken or unsupported corner: drop the whole face
+							break;
 						}
 
-						vertices.push_back(vertex);
-						tempIndices[iFace] = uint32_t(vertices.size()) - 1;
-						//indices.push_back(uint32_t(vertices.size()) - 1);
+						const auto [it, isNew] = cornerToVertex.try_emplace(corner, static_cast<uint32_t>(vertices.size()));
+						if (isNew)
+							vertices.push_back(MakeObjVertex(corner, positions, UVs, normals));
+						faceVertices.push_back(it->second);
 					}
 
-					indices.push_back(tempIndices[0]);
-					if (flipAxisAndWinding) 
-					{
-						indices.push_back(tempIndices[2]);
-						indices.push_back(tempIndices[1]);
-					}
-					else
-					{
-						indices.push_back(tempIndices[1]);
-						indices.push_back(tempIndices[2]);
-					}
+					if (isValidFace)
+						AppendObjFace(faceVertices, flipAxisAndWinding, indices);
 				}
-				//read till end of line and ignore all remaining chars
-				file.ignore(1000, '\n');
+				// Anything else (comments, objects, materials) is ignored
 			}
 
-			//Cheap Tangent Calculations
-			for (uint32_t i = 0; i < indices.size(); i += 3)
+			for (size_t i = 0; i < indices.size(); i += 3)
 			{
-				uint32_t index0 = indices[i];
-				uint32_t index1 = indices[size_t(i) + 1];
-				uint32_t index2 = indices[size_t(i) + 2];
-
-				const Vector3& p0 = vertices[index0].position;
-				const Vector3& p1 = vertices[index1].position;
-				const Vector3& p2 = vertices[index2].position;
-				const Vector2& uv0 = vertices[index0].uv;
-				const Vector2& uv1 = vertices[index1].uv;
-				const Vector2& uv2 = vertices[index2].uv;
-
-				const Vector3 edge0 = p1 - p0;
-				const Vector3 edge1 = p2 - p0;
-				const Vector2 diffX = Vector2(uv1.x - uv0.x, uv2.x - uv0.x);
-				const Vector2 diffY = Vector2(uv1.y - uv0.y, uv2.y - uv0.y);
-				float r = 1.f / Vector2::Cross(diffX, diffY);
-
-				Vector3 tangent = (edge0 * diffY.y - edge1 * diffY.x) * r;
-				vertices[index0].tangent += tangent;
-				vertices[index1].tangent += tangent;
-				vertices[index2].tangent += tangent;
+				Vector3 tangent{};
+				if (!ComputeTriangleTangent(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]], tangent))
+					continue;
+
+				vertices[indices[i]].tangent += tangent;
+				vertices[indices[i + 1]].tangent += tangent;
+				vertices[indices[i + 2]].tangent += tangent;
 			}
 
-			//Create the Tangents (reject)
 			for (auto& v : vertices)
-			{
-				v.tangent = Vector3::Reject(v.tangent, v.normal).Normalized();
+				FinalizeObjVertex(v, flipAxisAndWinding);
 
-				if(flipAxisAndWinding)
-				{
-					v.position.z *= -1.f;
-					v.normal.z *= -1.f;
-					v.tangent.z *= -1.f;
-				}
+			return true;
+		}
 
-			}
+		// ParseOBJ behind the binary mesh cache: parses, reorders for the vertex cache (and writes the cache) only when it is missing or stale,
+		// big files are parsed on every thread of pJobSystem
+		inline bool LoadOBJ(const std::string& filename, std::vector<Vertex_In>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true, JobSystem* pJobSystem = nullptr)
+		{
+			if (MeshCache::Load(filename, flipAxisAndWinding, vertices, indices))
+				return true;
+
+			std::error_code error{};
+			const bool isParallel = pJobSystem && pJobSystem->GetThreadCount() > 1
+				&& std::filesystem::file_size(filename, error) >= ParallelObjParser::MIN_FILE_SIZE && !error;
+			const bool isParsed = isParallel ? ParallelObjParser::Parse(filename, vertices, indices, flipAxisAndWinding, *pJobSystem)
+				: ParseOBJ(filename, vertices, indices, flipAxisAndWinding);
+			if (!isParsed)
+				return false;
+
+			const MeshOptimizer::Report report = MeshOptimizer::Optimize(vertices, indices);
+			std::cout << filename << ": ACMR " << report.acmrBefore << " -> " << report.acmrAfter << " (FIFO " << MeshOptimizer::VERTEX_CACHE_SIZE << ")\n";
 
+			MeshCache::Save(filename, flipAxisAndWinding, vertices, indices);
 			return true;
 		}
-#pragma warning(pop)
 	}
-}
\ No newline at end of file
+}
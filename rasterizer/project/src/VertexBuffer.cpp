@@ -0,0 +1,64 @@
+#include "pch.h"
+#include "Mesh.h"
+
+namespace dae
+{
+	VertexBuffer_In::VertexBuffer_In(const std::vector<Vertex_In>& vertices) :
+		count{ vertices.size() }
+	{
+		const size_t paddedSize = GetPaddedSize(count);
+		for (FloatStream* pStream : { &position.x, &position.y, &position.z, &uv.x, &uv.y,
+			&normal.x, &normal.y, &normal.z, &tangent.x, &tangent.y, &tangent.z })
+			pStream->resize(paddedSize);
+
+		for (size_t idx{}; idx < count; ++idx)
+		{
+			const Vertex_In& vertex = vertices[idx];
+			position.x[idx] = vertex.position.x;	position.y[idx] = vertex.position.y;	position.z[idx] = vertex.position.z;
+			uv.x[idx] = vertex.uv.x;				uv.y[idx] = vertex.uv.y;
+			normal.x[idx] = vertex.normal.x;		normal.y[idx] = vertex.normal.y;		normal.z[idx] = vertex.normal.z;
+			tangent.x[idx] = vertex.tangent.x;		tangent.y[idx] = vertex.tangent.y;		tangent.z[idx] = vertex.tangent.z;
+		}
+	}
+
+	void VertexBuffer_Out::Resize(size_t vertexCount)
+	{
+		count = vertexCount;
+
+		const size_t paddedSize = GetPaddedSize(count);
+		for (FloatStream* pStream : { &position.x, &position.y, &position.z, &position.w,
+			&clipPosition.x, &clipPosition.y, &clipPosition.z, &clipPosition.w, &uv.x, &uv.y,
+			&normal.x, &normal.y, &normal.z, &tangent.x, &tangent.y, &tangent.z,
+			&viewDirection.x, &viewDirection.y, &viewDirection.z })
+			pStream->resize(paddedSize);
+	}
+
+	Vertex_Out VertexBuffer_Out::GetVertex(size_t idx) const
+	{
+		Vertex_Out vertex{};
+		vertex.position = { position.x[idx], position.y[idx], position.z[idx], position.w[idx] };
+		vertex.uv = { uv.x[idx], uv.y[idx] };
+		vertex.normal = { normal.x[idx], normal.y[idx], normal.z[idx] };
+		vertex.tangent = { tangent.x[idx], tangent.y[idx], tangent.z[idx] };
+		vertex.viewDirection = { viewDirection.x[idx], viewDirection.y[idx], viewDirection.z[idx] };
+		return vertex;
+	}
+
+	Vector4 VertexBuffer_Out::GetClipPosition(size_t idx) const
+	{
+		return { clipPosition.x[idx], clipPosition.y[idx], clipPosition.z[idx], clipPosition.w[idx] };
+	}
+
+	uint32_t VertexBuffer_Out::AddVertex(const Vertex_Out& vertex)
+	{
+		const size_t idx = count;
+		Resize(count + 1);
+
+		position.x[idx] = vertex.position.x;		position.y[idx] = vertex.position.y;		position.z[idx] = vertex.position.z;		position.w[idx] = vertex.position.w;
+		uv.x[idx] = vertex.uv.x;					uv.y[idx] = vertex.uv.y;
+		normal.x[idx] = vertex.normal.x;			normal.y[idx] = vertex.normal.y;			normal.z[idx] = vertex.normal.z;
+		tangent.x[idx] = vertex.tangent.x;			tangent.y[idx] = vertex.tangent.y;			tangent.z[idx] = vertex.tangent.z;
+		viewDirection.x[idx] = vertex.viewDirection.x;	viewDirection.y[idx] = vertex.viewDirection.y;	viewDirection.z[idx] = vertex.viewDirection.z;
+		return static_cast<uint32_t>(idx);
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+//includes
+#include <new>
+#include <vector>
+#include "Math.h"
+#include "Simd.h"
+
+namespace dae
+{
+	struct Vertex_In;
+	struct Vertex_Out;
+
+	constexpr size_t CACHE_LINE_SIZE{ 64 };
+
+	// Allocates on cache line boundaries
+	template<typename T>
+	struct AlignedAllocator
+	{
+		using value_type = T;
+
+		AlignedAllocator() = default;
+		template<typename U>
+		AlignedAllocator(const AlignedAllocator<U>&) {}
+
+		T* allocate(size_t count)
+		{
+			return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{ CACHE_LINE_SIZE }));
+		}
+		void deallocate(T* p, size_t)
+		{
+			::operator delete(p, std::align_val_t{ CACHE_LINE_SIZE });
+		}
+
+		template<typename U>
+		bool operator==(const AlignedAllocator<U>&) const { return true; }
+	};
+
+	using FloatStream = std::vector<float, AlignedAllocator<float>>;
+
+	struct Stream2 { FloatStream x, y; };
+	struct Stream3 { FloatStream x, y, z; };
+	struct Stream4 { FloatStream x, y, z, w; };
+
+	// Streams are padded to whole SIMD batches, so batched loops never need a tail
+	inline size_t GetPaddedSize(size_t count)
+	{
+		return (count + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+	}
+
+	// Software vertices as structure of arrays: every component is its own stream,
+	// a stage only touches the streams it needs
+	struct VertexBuffer_In
+	{
+		Stream3 position{};
+		Stream2 uv{};
+		Stream3 normal{};
+		Stream3 tangent{};
+
+		size_t count{};
+
+		VertexBuffer_In() = default;
+		explicit VertexBuffer_In(const std::vector<Vertex_In>& vertices);
+
+		size_t Size() const { return count; };
+	};
+
+	struct VertexBuffer_Out
+	{
+		Stream4 position{};			// screen x, y + ndc z + view depth w
+		Stream4 clipPosition{};		// before the perspective divide (clipping)
+		Stream2 uv{};
+		Stream3 normal{};
+		Stream3 tangent{};
+		Stream3 viewDirection{};
+
+		size_t count{};
+
+		void Resize(size_t vertexCount);
+		size_t Size() const { return count; };
+
+		Vertex_Out GetVertex(size_t idx) const;
+		Vector4 GetClipPosition(size_t idx) const;
+		uint32_t AddVertex(const Vertex_Out& vertex);
+	};
+}
@@ -6,6 +6,7 @@
 
 #undef main
 #include "Renderer.h"
+#include "Benchmark.h"
 
 using namespace dae;
 
@@ -17,9 +18,13 @@ void ShutDown(SDL_Window* pWindow)
 
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	//Headless benchmark (--benchmark): software rasterizer only, no window/DirectX
+	BenchmarkSettings benchmarkSettings{};
+	if (Benchmark::ParseArguments(argc, args, benchmarkSettings))
+	{
+		Benchmark benchmark{ benchmarkSettings };
+		return benchmark.Run();
+	}
 
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
@@ -38,7 +43,7 @@ int main(int argc, char* args[])
 
 	//Initialize "framework"
 	const auto pTimer = new Timer();
-	const auto pRenderer = new Renderer(pWindow);
+	const auto pRenderer = new Renderer(pWindow, benchmarkSettings.sampleCount);	// --msaa n
 
 	// Keybinds std::cout
 	{
@@ -47,27 +52,28 @@ int main(int argc, char* args[])
 		std::cout << STRINGCOLOR_SHARED_CYAN << "[Key Bindings - SHARED]" << std::endl;
 		std::cout << STRINGCOLOR_SHARED_CYAN << "   [F1]  Toggle Rasterizer Mode (HARDWARE/SOFTWARE)" << std::endl;
 		std::cout << STRINGCOLOR_SHARED_CYAN << "   [F2]  Toggle Vehicle Rotation (ON/OFF)" << std::endl;
+		std::cout << STRINGCOLOR_SHARED_CYAN << "   [F3]  Toggle FireFX (ON/OFF)" << std::endl;
+		std::cout << STRINGCOLOR_SHARED_CYAN << "   [F4]  Cycle Sampler State (POINT/LINEAR/ANISOTROPIC)" << std::endl;
 		std::cout << STRINGCOLOR_SHARED_CYAN << "   [F9]  Cycle CullMode (BACK/FRONT/NONE)" << std::endl;
 		std::cout << STRINGCOLOR_SHARED_CYAN << "   [F10] Toggle Uniform ClearColor (ON/OFF)" << std::endl;
 		std::cout << STRINGCOLOR_SHARED_CYAN << "   [F11] Toggle Print FPS (ON/OFF)" << std::endl;
 
-		// Hardware Key Bindings
-		std::cout << STRINGCOLOR_HARDWARE_YELLOW << "\n[Key Bindings - HARDWARE]" << std::endl;
-		std::cout << STRINGCOLOR_HARDWARE_YELLOW << "   [F3] Toggle FireFX (ON/OFF)" << std::endl;
-		std::cout << STRINGCOLOR_HARDWARE_YELLOW << "   [F4] Cycle Sampler State (POINT/LINEAR/ANISOTROPIC)" << std::endl;
-
 		// Software Key Bindings
 		std::cout <<STRINGCOLOR_SOFTWARE_GREEN << "\n[Key Bindings - SOFTWARE]" << std::endl;
 		std::cout <<STRINGCOLOR_SOFTWARE_GREEN << "   [F5] Cycle Shading Mode (COMBINED/OBSERVED_AREA/DIFFUSE/SPECULAR)" << std::endl;
 		std::cout <<STRINGCOLOR_SOFTWARE_GREEN << "   [F6] Toggle NormalMap (ON/OFF)" << std::endl;
 		std::cout <<STRINGCOLOR_SOFTWARE_GREEN << "   [F7] Toggle DepthBuffer Visualization (ON/OFF)" << std::endl;
-		std::cout <<STRINGCOLOR_SOFTWARE_GREEN << "   [F8] Toggle BoundingBox Visualization (ON/OFF)\n\n" << STRINGCOLOR_RESET << std::endl;
+		std::cout <<STRINGCOLOR_SOFTWARE_GREEN << "   [F8] Toggle BoundingBox Visualization (ON/OFF)" << std::endl;
+		std::cout <<STRINGCOLOR_SOFTWARE_GREEN << "   [F12] Toggle Deferred Shading (ON/OFF)\n\n" << STRINGCOLOR_RESET << std::endl;
 	}
 
 	// FPS COLOR
 	const std::string STRINGCOLOR_RESET = "\033[0m";
 	const std::string STRINGCOLOR_GREY = "\033[38;5;238m";
 
+	if (!benchmarkSettings.tracePath.empty())	// --trace path [--trace-frames n]: the first frames
+		pRenderer->GetProfiler().StartTrace(benchmarkSettings.tracePath, benchmarkSettings.traceFrameCount);
+
 	//Start loop
 	pTimer->Start();
 	float printTimer = 0.f;
@@ -89,6 +95,10 @@ int main(int argc, char* args[])
 					pRenderer->SwitchRasterizerMode();
 				if (e.key.keysym.scancode == SDL_SCANCODE_F2)	// Toggle Rotation (Rotate/Idle) (F2)
 					pRenderer->ToggleRotation();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F3)	// Toggle fire mesh (F3)
+					pRenderer->ToggleFireMesh();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F4)	// Switch filtering mode (F4)
+					pRenderer->SwitchFilterMode();
 				if (e.key.keysym.scancode == SDL_SCANCODE_F9)	// Switch CullMode (F9)
 					pRenderer->SwitchCullMode();
 				if (e.key.keysym.scancode == SDL_SCANCODE_F10)	// Toggle Uniform Color (F10)
@@ -96,12 +106,6 @@ int main(int argc, char* args[])
 				if (e.key.keysym.scancode == SDL_SCANCODE_F11)	// Toggle FPS Printing (F11)
 					pRenderer->TogglePrintFPS();
 
-				//HARDWARE
-				if (e.key.keysym.scancode == SDL_SCANCODE_F3)	// Toggle fire mesh (F3)
-					pRenderer->ToggleFireMesh();
-				if (e.key.keysym.scancode == SDL_SCANCODE_F4)	// Switch filtering mode (F4)
-					pRenderer->SwitchFilterMode();
-
 				//SOFTWARE
 				if (e.key.keysym.scancode == SDL_SCANCODE_F5)	// Switch ShadingMode (F5)
 					pRenderer->SwitchShadingMode();
@@ -111,6 +115,8 @@ int main(int argc, char* args[])
 					pRenderer->ToggleDepthVisualization();
 				if (e.key.keysym.scancode == SDL_SCANCODE_F8)	// Switch AABB Visualization (F8)
 					pRenderer->ToggleAABBVisualization();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F12)	// Toggle Deferred Shading (F12)
+					pRenderer->ToggleDeferredShading();
 
 				
 				break;
@@ -136,6 +142,11 @@ int main(int argc, char* args[])
 	}
 	pTimer->Stop();
 
+	if (!benchmarkSettings.profilePath.empty() && !pRenderer->GetProfiler().Write(benchmarkSettings.profilePath))	// --profile path: last frames
+		std::cout << "Could not write " << benchmarkSettings.profilePath << std::endl;
+	if (!pRenderer->GetProfiler().StopTrace())	// closed before all frames were traced
+		std::cout << "Could not write " << benchmarkSettings.tracePath << std::endl;
+
 	//Shutdown "framework"
 	delete pRenderer;
 	delete pTimer;
@@ -7,17 +7,29 @@
 #include <memory>
 #define NOMINMAX  //for directx
 
+// Hardware rasterizer (DirectX 11, Windows only), 0 builds the software rasterizer alone (CMake option ENABLE_DIRECTX)
+#ifndef ENABLE_DIRECTX
+#ifdef _WIN32
+#define ENABLE_DIRECTX 1
+#else
+#define ENABLE_DIRECTX 0
+#endif
+#endif
+
 // SDL Headers
 #include "SDL.h"
-#include "SDL_syswm.h"
 #include "SDL_surface.h"
 #include "SDL_image.h"
 
+#if ENABLE_DIRECTX
+#include "SDL_syswm.h"
+
 // DirectX Headers
 #include <dxgi.h>
 #include <d3d11.h>
 #include <d3dcompiler.h>
 #include <d3dx11effect.h>
+#endif
 
 // Framework Headers
 #include "Timer.h"